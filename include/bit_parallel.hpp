@@ -0,0 +1,146 @@
+#pragma once
+
+#include "glushkov.hpp"
+#include "optimise.hpp"
+#include "parser.hpp"
+#include "util.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace scry {
+
+/**
+ * Matches a regex of at most 64 positions by simulating its Glushkov automaton
+ * with one bit per position (Shift-And). Every input symbol costs one lookup
+ * per 8 positions in a table of follow sets and a mask with the positions
+ * which accept the symbol, so matching is linear in the input and never
+ * backtracks.
+ */
+template <typename regex> class bit_parallel {
+  using tree = typename parse_result<
+      regex, std::make_index_sequence<regex::string::size>>::type;
+  using opt_tree = typename optimise_result<tree>::type;
+  using automaton_type = glushkov_result<opt_tree>;
+
+  constexpr static const std::size_t positions = automaton_type::size - 1;
+
+  static_assert(positions <= 64,
+                "bit_parallel supports patterns of at most 64 positions");
+
+  constexpr static const std::size_t chunks =
+      positions == 0 ? 1 : (positions + 7) / 8;
+
+  /**
+   * Position p of the automaton is stored in bit p - 1, as the initial
+   * position is only ever occupied before the first symbol
+   */
+  struct tables {
+    std::uint64_t symbols[256]{};
+    std::uint64_t follow[chunks][256]{};
+    std::uint64_t first{0};
+    std::uint64_t last{0};
+    bool nullable{false};
+    bool left_anchored{false};
+    bool right_anchored{false};
+  };
+
+  template <typename set_type>
+  constexpr static std::uint64_t mask(const set_type &set) noexcept {
+    std::uint64_t result = 0;
+    for (std::size_t p = 1; p <= positions; ++p) {
+      if (set.test(p)) {
+        result |= std::uint64_t{1} << (p - 1);
+      }
+    }
+    return result;
+  }
+
+  constexpr static tables make() noexcept {
+    const auto &automaton = automaton_type::value;
+    tables result{};
+    for (std::size_t c = 0; c < 256; ++c) {
+      result.symbols[c] = mask(automaton.by_symbol[c]);
+    }
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+      for (std::size_t bits = 0; bits < 256; ++bits) {
+        for (std::size_t bit = 0; bit < 8; ++bit) {
+          const std::size_t p = chunk * 8 + bit + 1;
+          if (((bits >> bit) & 1) && p <= positions) {
+            result.follow[chunk][bits] |= mask(automaton.follow[p]);
+          }
+        }
+      }
+    }
+    result.first = mask(automaton.follow[0]);
+    result.last = mask(automaton.last);
+    result.nullable = automaton.last.test(0);
+    result.left_anchored = automaton.left_anchored;
+    result.right_anchored = automaton.right_anchored;
+    return result;
+  }
+
+  constexpr static const tables table = make();
+
+  /**
+   * Positions which may follow any of the positions in `state`
+   */
+  constexpr static std::uint64_t follow(std::uint64_t state) noexcept {
+    std::uint64_t result = 0;
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+      result |= table.follow[chunk][(state >> (chunk * 8)) & 0xFF];
+    }
+    return result;
+  }
+
+  template <typename symbol_type>
+  constexpr static std::uint64_t accepting(symbol_type c) noexcept {
+    static_assert(sizeof(symbol_type) == 1,
+                  "bit-parallel matching can only match bytes");
+    return table.symbols[unit_value(c)];
+  }
+
+public:
+  template <typename it_type>
+  constexpr static bool match(it_type begin, it_type end) noexcept {
+    if (begin == end) {
+      return table.nullable;
+    }
+    std::uint64_t state = table.first & accepting(*begin);
+    for (++begin; begin != end && state != 0; ++begin) {
+      state = follow(state) & accepting(*begin);
+    }
+    return begin == end && (state & table.last) != 0;
+  }
+
+  /**
+   * Determines whether any substring of the input matches, honouring anchors
+   */
+  template <typename it_type>
+  constexpr static bool search(it_type begin, it_type end) noexcept {
+    if (table.left_anchored && table.right_anchored) {
+      return match(begin, end);
+    }
+    if (table.nullable) {
+      return true;
+    }
+    std::uint64_t state = 0;
+    std::uint64_t first = table.first;
+    for (; begin != end; ++begin) {
+      state = (follow(state) | first) & accepting(*begin);
+      if (table.left_anchored) {
+        if (state == 0) {
+          return false;
+        }
+        first = 0;
+      }
+      if (!table.right_anchored && (state & table.last) != 0) {
+        return true;
+      }
+    }
+    return (state & table.last) != 0;
+  }
+};
+
+} // namespace scry
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "parser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace scry {
+
+/**
+ * Set of symbols stored as a 256-bit mask indexed by the unsigned value of
+ * each symbol
+ */
+struct char_set {
+  std::uint64_t words[4]{};
+
+  constexpr static std::size_t index(char c) noexcept {
+    return static_cast<unsigned char>(c);
+  }
+
+  constexpr bool contains(char c) const noexcept {
+    const std::size_t i = index(c);
+    return (words[i >> 6] >> (i & 63)) & 1;
+  }
+
+  constexpr void insert(char c) noexcept {
+    const std::size_t i = index(c);
+    words[i >> 6] |= std::uint64_t{1} << (i & 63);
+  }
+
+  /**
+   * Inserts every symbol between `lower` and `upper`, compared by unsigned
+   * value in the same way as `pred::in_range`
+   */
+  constexpr void insert(char lower, char upper) noexcept {
+    for (std::size_t i = index(lower); i <= index(upper); ++i) {
+      insert(static_cast<char>(i));
+    }
+  }
+
+  constexpr std::size_t count() const noexcept {
+    std::size_t result = 0;
+    for (std::uint64_t word : words) {
+      for (; word != 0; word &= word - 1) {
+        ++result;
+      }
+    }
+    return result;
+  }
+
+  constexpr bool empty() const noexcept { return count() == 0; }
+
+  constexpr char_set operator|(const char_set &other) const noexcept {
+    char_set result{};
+    for (std::size_t i = 0; i < 4; ++i) {
+      result.words[i] = words[i] | other.words[i];
+    }
+    return result;
+  }
+
+  constexpr char_set operator&(const char_set &other) const noexcept {
+    char_set result{};
+    for (std::size_t i = 0; i < 4; ++i) {
+      result.words[i] = words[i] & other.words[i];
+    }
+    return result;
+  }
+
+  constexpr char_set operator~() const noexcept {
+    char_set result{};
+    for (std::size_t i = 0; i < 4; ++i) {
+      result.words[i] = ~words[i];
+    }
+    return result;
+  }
+
+  constexpr bool operator==(const char_set &other) const noexcept {
+    for (std::size_t i = 0; i < 4; ++i) {
+      if (words[i] != other.words[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  constexpr bool operator!=(const char_set &other) const noexcept {
+    return !(*this == other);
+  }
+
+  constexpr static char_set of(char c) noexcept {
+    char_set result{};
+    result.insert(c);
+    return result;
+  }
+
+  constexpr static char_set all() noexcept { return ~char_set{}; }
+};
+
+/**
+ * Determines the set of symbols accepted by a single-symbol AST
+ */
+template <typename ast> struct char_set_of;
+
+template <char c> struct char_set_of<ast::symbol<c>> {
+  constexpr static const char_set value = char_set::of(c);
+};
+
+template <> struct char_set_of<ast::any> {
+  constexpr static const char_set value = char_set::all();
+};
+
+template <char lower, char upper> struct char_set_of<ast::range<lower, upper>> {
+  constexpr static char_set make() noexcept {
+    char_set result{};
+    result.insert(lower, upper);
+    return result;
+  }
+  constexpr static const char_set value = make();
+};
+
+template <typename... nested> struct char_set_of<ast::any_of<nested...>> {
+  constexpr static const char_set value =
+      (char_set{} | ... | char_set_of<nested>::value);
+};
+
+template <typename... nested> struct char_set_of<ast::none_of<nested...>> {
+  constexpr static const char_set value =
+      ~char_set_of<ast::any_of<nested...>>::value;
+};
+
+} // namespace scry
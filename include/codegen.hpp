@@ -1,13 +1,109 @@
 #pragma once
 
+#include "optimise.hpp"
 #include "parser.hpp"
+#include "profile.hpp"
+#include "util.hpp"
 
 #include <cstdio>
 
 namespace scry {
 
+namespace pred {
+
+template <char c> struct equals;
+template <typename nested> struct negate;
+
+} // namespace pred
+
+namespace {
+
+/**
+ * Determines whether `op` may accept input starting at `begin`, by testing the
+ * symbol at `begin` against the FIRST set of `op` (see first.hpp)
+ */
+template <typename op, typename it_type>
+constexpr bool may_start(it_type begin, it_type end) noexcept;
+
+} // anonymous namespace
+
 namespace op {
 
+template <typename nested> struct op_if;
+
+/**
+ * Number of ops in the code of a program once every op is inlined, as an
+ * estimate of the size of that code. Greedy quantifiers probe their
+ * continuation in two places, so inline two copies of it.
+ */
+template <typename op> struct program_size {
+  constexpr static const std::size_t value = 1;
+};
+
+/**
+ * Executes `op` through a function which is never inlined, so that every
+ * program containing `op` shares a single copy of its code
+ */
+template <typename op> struct outlined {
+  template <typename it_type>
+  SCRY_NOINLINE constexpr static maybe<it_type> execute(it_type begin,
+                                                        it_type end) noexcept {
+    return op::execute(begin, end);
+  }
+};
+
+/**
+ * Executes `op`, inlined unless it is larger than `SCRY_INLINE_LIMIT`
+ */
+template <typename op, typename it_type>
+SCRY_INLINE constexpr maybe<it_type> invoke(it_type begin,
+                                            it_type end) noexcept {
+  if constexpr (program_size<op>::value > SCRY_INLINE_LIMIT) {
+    return outlined<op>::execute(begin, end);
+  } else {
+    return op::execute(begin, end);
+  }
+}
+
+/**
+ * Executes `op`, recording the execution when profiling is enabled
+ */
+template <typename op, typename it_type>
+SCRY_INLINE constexpr maybe<it_type> dispatch(it_type begin,
+                                              it_type end) noexcept {
+  if constexpr (profile::enabled) {
+    maybe<it_type> result = invoke<op>(begin, end);
+    if (!SCRY_CONSTANT_EVALUATED()) {
+      profile::record_execution<op>(begin, result);
+    }
+    return result;
+  } else {
+    return invoke<op>(begin, end);
+  }
+}
+
+/**
+ * Executes `next` on behalf of the quantifier `op`, recording the probe when
+ * profiling is enabled. Positions at which `next` cannot start are rejected
+ * by a single test against its FIRST set rather than by executing it.
+ */
+template <typename op, typename next, typename it_type>
+SCRY_INLINE constexpr maybe<it_type> probe(it_type begin,
+                                           it_type end) noexcept {
+  if (!may_start<next>(begin, end)) {
+    return {};
+  }
+  if constexpr (profile::enabled) {
+    maybe<it_type> result = dispatch<next>(begin, end);
+    if (!SCRY_CONSTANT_EVALUATED()) {
+      profile::record_probe<op>(result);
+    }
+    return result;
+  } else {
+    return invoke<next>(begin, end);
+  }
+}
+
 /**
  * Structure containing a sequence of operations which must be accepted in
  * sequence
@@ -19,7 +115,7 @@ struct accept_sequence<head, tail...> {
   template <typename it_type>
   SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
                                                       it_type end) noexcept {
-    if (auto it = head::execute(begin, end)) {
+    if (auto it = dispatch<head>(begin, end)) {
       return accept_sequence<tail...>::execute(*it, end);
     } else {
       return {};
@@ -42,7 +138,7 @@ template <char c> struct accept {
   template <typename it_type>
   SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
                                                       it_type end) noexcept {
-    if (begin != end && *begin == c) {
+    if (begin != end && unit_value(*begin) == unit_value(c)) {
       return ++begin;
     } else {
       return {};
@@ -54,7 +150,7 @@ template <char c> struct reject {
   template <typename it_type>
   SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
                                                       it_type end) noexcept {
-    if (begin != end && *begin != c) {
+    if (begin != end && unit_value(*begin) != unit_value(c)) {
       return ++begin;
     } else {
       return {};
@@ -78,25 +174,40 @@ struct accept_any {
 };
 
 /**
- * Structure representing the none-or-more operation (*)
+ * Structure representing a sequence which can never match (see `ast::never`)
+ */
+struct accept_nothing {
+  template <typename it_type>
+  SCRY_INLINE constexpr static maybe<it_type>
+  execute([[maybe_unused]] it_type begin,
+          [[maybe_unused]] it_type end) noexcept {
+    return {};
+  }
+};
+
+/**
+ * Structure representing the none-or-more operation (*). Greedy quantifiers
+ * accept the last repetition after which `next` accepts, unless `next`
+ * accepts the rest of the input after an earlier one, which no later
+ * repetition can improve on and so is accepted at once. Programs therefore
+ * reach the end of the input whenever any choice of repetitions does.
  *
- * TODO: Ensure nested `zero_or_more`s are handled properly (e.g. a****). This
- *       code assumes that they are never nested. There is a good case here for
- *       disallowing such a structure from being generated as it may simplify
- *       generated code.
+ * Note: `nested` never contains a quantifier, as nested quantifiers are
+ *       collapsed by `normalise` and rejected by `generate_op` otherwise, so
+ *       every repetition of `nested` accepts a fixed amount of input.
  */
 template <typename nested, typename next> struct accept_zero_or_more {
   template <typename it_type>
   SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
                                                       it_type end) noexcept {
-    maybe<it_type> best = next::execute(begin, end);
-    while (begin != end) {
-      if (auto it = nested::execute(begin, end)) {
+    maybe<it_type> best = probe<accept_zero_or_more, next>(begin, end);
+    while (begin != end && !(best == end)) {
+      if (auto it = dispatch<nested>(begin, end)) {
         begin = it;
       } else {
         return best;
       }
-      if (auto it = next::execute(begin, end)) {
+      if (auto it = probe<accept_zero_or_more, next>(begin, end)) {
         best = it;
       }
     }
@@ -106,7 +217,7 @@ template <typename nested, typename next> struct accept_zero_or_more {
 
 /**
  * Specialization of `accept_zero_or_more` for cases where there is not a
- * next operation
+ * next operation, so the rest of the input must be repetitions of `nested`
  */
 template <typename nested>
 struct accept_zero_or_more<nested, op::accept_sequence<>> {
@@ -114,7 +225,7 @@ struct accept_zero_or_more<nested, op::accept_sequence<>> {
   SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
                                                       it_type end) noexcept {
     while (begin != end) {
-      if (auto it = nested::execute(begin, end)) {
+      if (auto it = dispatch<nested>(begin, end)) {
         begin = it;
       } else {
         return {};
@@ -124,24 +235,93 @@ struct accept_zero_or_more<nested, op::accept_sequence<>> {
   }
 };
 
+/**
+ * Structure representing the none-or-more operation at the end of a program
+ * which may accept a prefix of the input (see `prefix_codegen_result`), so
+ * every repetition is accepted and none need be probed
+ */
+template <typename nested> struct accept_trailing {
+  template <typename it_type>
+  SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
+                                                      it_type end) noexcept {
+    while (begin != end) {
+      if (auto it = dispatch<nested>(begin, end)) {
+        begin = it;
+      } else {
+        break;
+      }
+    }
+    return begin;
+  }
+};
+
+/**
+ * Specialization of `accept_zero_or_more` for ".*" at the end of a program,
+ * which accepts the rest of the input
+ */
+template <> struct accept_zero_or_more<accept_any, op::accept_sequence<>> {
+  template <typename it_type>
+  SCRY_INLINE constexpr static maybe<it_type>
+  execute([[maybe_unused]] it_type begin, it_type end) noexcept {
+    return end;
+  }
+};
+
 /**
  * Specialization of `accept_zero_or_more` for cases where a single symbol
- * follows
+ * follows and `nested` cannot accept that symbol, so only its first occurrence
+ * needs to be considered
  */
 template <typename nested, typename until, typename next> struct accept_until {
   template <typename it_type>
   SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
                                                       it_type end) noexcept {
     while (begin != end) {
-      if (auto it = until::execute(begin, end)) {
-        return next::execute(*it, end);
-      } else if (auto it = nested::execute(begin, end)) {
+      if (auto it = dispatch<until>(begin, end)) {
+        return probe<accept_until, next>(*it, end);
+      } else if (auto it = dispatch<nested>(begin, end)) {
         begin = it;
       } else {
         return {};
       }
     }
-    return begin;
+    return {};
+  }
+};
+
+/**
+ * Specialization of `accept_until` for "[^c]*c", where every symbol before the
+ * first occurrence of c is accepted and so can be skipped over with `memchr`
+ */
+template <char c, typename next>
+struct accept_until<op_if<pred::negate<pred::equals<c>>>, accept<c>, next> {
+  template <typename it_type>
+  SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
+                                                      it_type end) noexcept {
+    begin = find_symbol(begin, end, c);
+    if (begin == end) {
+      return {};
+    }
+    return probe<accept_until, next>(++begin, end);
+  }
+};
+
+/**
+ * Specialization of `accept_until` for ".*c", which is greedy and so probes
+ * `next` after every occurrence of c, jumping between them with `memchr`
+ */
+template <char c, typename next>
+struct accept_until<accept_any, accept<c>, next> {
+  template <typename it_type>
+  SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
+                                                      it_type end) noexcept {
+    maybe<it_type> best{};
+    while (!(best == end) && (begin = find_symbol(begin, end, c)) != end) {
+      if (auto it = probe<accept_until, next>(++begin, end)) {
+        best = it;
+      }
+    }
+    return best;
   }
 };
 
@@ -183,7 +363,7 @@ template <std::size_t n, typename nested> struct accept_n {
   SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
                                                       it_type end) noexcept {
     for (std::size_t i = 0; i < n; ++i) {
-      if (auto it = nested::execute(begin, end)) {
+      if (auto it = dispatch<nested>(begin, end)) {
         begin = it;
       } else {
         return {};
@@ -200,14 +380,14 @@ template <std::size_t n, typename nested, typename next> struct accept_at_most {
   template <typename it_type>
   SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
                                                       it_type end) noexcept {
-    maybe<it_type> best = next::execute(begin, end);
-    for (std::size_t i = 0; i < n; ++i) {
-      if (auto it = nested::execute(begin, end)) {
+    maybe<it_type> best = probe<accept_at_most, next>(begin, end);
+    for (std::size_t i = 0; i < n && !(best == end); ++i) {
+      if (auto it = dispatch<nested>(begin, end)) {
         begin = it;
       } else {
         break;
       }
-      if (auto it = next::execute(begin, end)) {
+      if (auto it = probe<accept_at_most, next>(begin, end)) {
         best = it;
       }
     }
@@ -216,13 +396,15 @@ template <std::size_t n, typename nested, typename next> struct accept_at_most {
 };
 
 /**
- * Structure representing a range of symbols which may be accepted
+ * Structure representing a range of symbols which may be accepted, where
+ * symbols are compared by their unsigned value (see `unit_value`)
  */
 template <char lower, char upper> struct accept_range {
   template <typename it_type>
   SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
                                                       it_type end) noexcept {
-    if (begin != end && ((lower <= *begin) & (*begin <= upper))) {
+    if (begin != end && ((unit_value(lower) <= unit_value(*begin)) &
+                         (unit_value(*begin) <= unit_value(upper)))) {
       return ++begin;
     } else {
       return {};
@@ -237,7 +419,8 @@ template <char lower, char upper> struct reject_range {
   template <typename it_type>
   SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
                                                       it_type end) noexcept {
-    if (begin != end && ((lower > *begin) | (*begin > upper))) {
+    if (begin != end && ((unit_value(lower) > unit_value(*begin)) |
+                         (unit_value(*begin) > unit_value(upper)))) {
       return ++begin;
     } else {
       return {};
@@ -245,6 +428,34 @@ template <char lower, char upper> struct reject_range {
   }
 };
 
+/**
+ * Structure representing a UTF-8 class, which accepts the bytes of a single
+ * code point. Each op accepts the encodings of a range of code points and at
+ * most one op accepts any input, so the first to accept is the result. ASCII
+ * input is only tested against the single-byte `ascii` ops.
+ */
+template <typename ascii, typename multibyte> struct accept_utf8;
+
+template <typename... ascii, typename... multibyte>
+struct accept_utf8<list<ascii...>, list<multibyte...>> {
+  template <typename it_type>
+  SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
+                                                      it_type end) noexcept {
+    static_assert(has_byte_units<it_type>::value,
+                  "UTF-8 classes can only match bytes");
+    maybe<it_type> result{};
+    if (begin == end) {
+      return result;
+    }
+    if (unit_value(*begin) < 0x80) {
+      static_cast<void>(((result = dispatch<ascii>(begin, end)) || ...));
+    } else {
+      static_cast<void>(((result = dispatch<multibyte>(begin, end)) || ...));
+    }
+    return result;
+  }
+};
+
 template <typename nested> struct op_if {
   template <typename it_type>
   SCRY_INLINE constexpr static maybe<it_type> execute(it_type begin,
@@ -257,36 +468,82 @@ template <typename nested> struct op_if {
   }
 };
 
+template <typename... ops> struct program_size<accept_sequence<ops...>> {
+  constexpr static const std::size_t value =
+      (std::size_t{0} + ... + program_size<ops>::value);
+};
+
+template <typename nested, typename next>
+struct program_size<accept_zero_or_more<nested, next>> {
+  constexpr static const std::size_t value =
+      1 + program_size<nested>::value + 2 * program_size<next>::value;
+};
+
+template <typename nested> struct program_size<accept_trailing<nested>> {
+  constexpr static const std::size_t value = 1 + program_size<nested>::value;
+};
+
+template <typename nested, typename until, typename next>
+struct program_size<accept_until<nested, until, next>> {
+  constexpr static const std::size_t value =
+      1 + program_size<nested>::value + program_size<until>::value +
+      program_size<next>::value;
+};
+
+template <std::size_t n, typename nested>
+struct program_size<accept_n<n, nested>> {
+  constexpr static const std::size_t value = 1 + program_size<nested>::value;
+};
+
+template <std::size_t n, typename nested, typename next>
+struct program_size<accept_at_most<n, nested, next>> {
+  constexpr static const std::size_t value =
+      1 + program_size<nested>::value + 2 * program_size<next>::value;
+};
+
+template <typename... ascii, typename... multibyte>
+struct program_size<accept_utf8<list<ascii...>, list<multibyte...>>> {
+  constexpr static const std::size_t value =
+      (std::size_t{1} + ... + program_size<ascii>::value) +
+      (std::size_t{0} + ... + program_size<multibyte>::value);
+};
+
 } // namespace op
 
 namespace pred {
 
 template <char c0> struct equals {
-  SCRY_INLINE constexpr static bool execute(char c1) noexcept {
-    return c0 == c1;
+  template <typename unit>
+  SCRY_INLINE constexpr static bool execute(unit c1) noexcept {
+    return unit_value(c0) == unit_value(c1);
   }
 };
 
 template <char lower, char upper> struct in_range {
-  SCRY_INLINE constexpr static bool execute(char c) noexcept {
-    return (lower <= c) & (c <= upper);
+  template <typename unit>
+  SCRY_INLINE constexpr static bool execute(unit c) noexcept {
+    return (unit_value(lower) <= unit_value(c)) &
+           (unit_value(c) <= unit_value(upper));
   }
 };
 
 template <typename nested> struct negate {
-  SCRY_INLINE constexpr static bool execute(char c) noexcept {
+  template <typename unit>
+  SCRY_INLINE constexpr static bool execute(unit c) noexcept {
     return !nested::execute(c);
   }
 };
 
 template <typename left, typename right> struct left_or_right {
-  SCRY_INLINE constexpr static bool execute(char c) noexcept {
+  template <typename unit>
+  SCRY_INLINE constexpr static bool execute(unit c) noexcept {
     return left::execute(c) | right::execute(c);
   }
 };
 
 template <typename left, typename right> struct left_and_right {
-  SCRY_INLINE constexpr static bool execute(char c) noexcept {
+  template <typename unit>
+  SCRY_INLINE constexpr static bool execute(unit c) noexcept {
     return left::execute(c) & right::execute(c);
   }
 };
@@ -295,62 +552,105 @@ template <typename left, typename right> struct left_and_right {
 
 namespace {
 
-template <typename op, typename ast> struct generate_ops;
+/**
+ * Generates the ops of a sequence, where `prefix` determines whether the
+ * program may accept a prefix of its input (see `prefix_codegen_result`)
+ * rather than only the whole of it
+ */
+template <typename op, typename ast, typename prefix = no> struct generate_ops;
 
 template <typename ast> struct generate_op;
 
 template <typename ast> struct generate_pred;
 
-template <typename op> struct generate_ops<op, ast::sequence<>> {
+/**
+ * Generates the op repeating `nested` none-or-more times before `next`
+ */
+template <typename nested, typename next, typename prefix>
+struct generate_zero_or_more {
+  using type = op::accept_zero_or_more<nested, next>;
+};
+
+template <typename nested>
+struct generate_zero_or_more<nested, op::accept_sequence<>, yes> {
+  using type = op::accept_trailing<nested>;
+};
+
+template <>
+struct generate_zero_or_more<op::accept_any, op::accept_sequence<>, yes> {
+  using type = op::accept_zero_or_more<op::accept_any, op::accept_sequence<>>;
+};
+
+template <typename op, typename prefix>
+struct generate_ops<op, ast::sequence<>, prefix> {
   using type = op;
 };
 
-template <typename... ops, typename head, typename... tail>
-struct generate_ops<op::accept_sequence<ops...>, ast::sequence<head, tail...>> {
+template <typename... ops, typename head, typename... tail, typename prefix>
+struct generate_ops<op::accept_sequence<ops...>, ast::sequence<head, tail...>,
+                    prefix> {
   using type = typename generate_ops<
       op::accept_sequence<ops..., typename generate_op<head>::type>,
-      ast::sequence<tail...>>::type;
+      ast::sequence<tail...>, prefix>::type;
 };
 
-template <typename... ops, typename nested, typename... asts>
+template <typename... ops, typename nested, typename... asts, typename prefix>
 struct generate_ops<op::accept_sequence<ops...>,
-                    ast::sequence<ast::zero_or_more<nested>, asts...>> {
+                    ast::sequence<ast::zero_or_more<nested>, asts...>, prefix> {
   using nested_op = typename generate_op<nested>::type;
   using next_op = typename generate_ops<op::accept_sequence<>,
-                                        ast::sequence<asts...>>::type;
-  using type =
-      op::accept_sequence<ops...,
-                          typename op::accept_zero_or_more<nested_op, next_op>>;
+                                        ast::sequence<asts...>, prefix>::type;
+  using type = op::accept_sequence<
+      ops...,
+      typename generate_zero_or_more<nested_op, next_op, prefix>::type>;
 };
 
-template <typename... ops, std::size_t n, typename nested, typename... asts>
+template <typename... ops, std::size_t n, typename nested, typename... asts,
+          typename prefix>
 struct generate_ops<op::accept_sequence<ops...>,
-                    ast::sequence<ast::at_least<n, nested>, asts...>> {
+                    ast::sequence<ast::at_least<n, nested>, asts...>, prefix> {
   using nested_op = typename generate_op<nested>::type;
   using next_op = typename generate_ops<op::accept_sequence<>,
-                                        ast::sequence<asts...>>::type;
-  using type =
-      typename op::accept_sequence<ops..., op::accept_n<n, nested_op>,
-                                   op::accept_zero_or_more<nested_op, next_op>>;
+                                        ast::sequence<asts...>, prefix>::type;
+  using type = typename op::accept_sequence<
+      ops..., op::accept_n<n, nested_op>,
+      typename generate_zero_or_more<nested_op, next_op, prefix>::type>;
 };
 
-template <typename... ops, std::size_t n, typename nested, typename... asts>
+template <typename... ops, std::size_t n, typename nested, typename... asts,
+          typename prefix>
 struct generate_ops<op::accept_sequence<ops...>,
-                    ast::sequence<ast::at_most<n, nested>, asts...>> {
+                    ast::sequence<ast::at_most<n, nested>, asts...>, prefix> {
   using nested_op = typename generate_op<nested>::type;
   using next_op = typename generate_ops<op::accept_sequence<>,
-                                        ast::sequence<asts...>>::type;
+                                        ast::sequence<asts...>, prefix>::type;
   using type =
       typename op::accept_sequence<ops...,
                                    op::accept_at_most<n, nested_op, next_op>>;
 };
 
+template <typename... ops, typename nested, typename until, typename... asts,
+          typename prefix>
+struct generate_ops<op::accept_sequence<ops...>,
+                    ast::sequence<ast::until<nested, until>, asts...>, prefix> {
+  using nested_op = typename generate_op<nested>::type;
+  using until_op = typename generate_op<until>::type;
+  using next_op = typename generate_ops<op::accept_sequence<>,
+                                        ast::sequence<asts...>, prefix>::type;
+  using type = typename op::accept_sequence<
+      ops..., op::accept_until<nested_op, until_op, next_op>>;
+};
+
 template <char c> struct generate_op<ast::symbol<c>> {
   using type = typename op::accept<c>;
 };
 
 template <> struct generate_op<ast::any> { using type = op::accept_any; };
 
+template <> struct generate_op<ast::never> {
+  using type = op::accept_nothing;
+};
+
 template <> struct generate_op<ast::left_anchor> {
   using type = op::left_anchor;
 };
@@ -376,6 +676,94 @@ template <typename... nested> struct generate_op<ast::none_of<nested...>> {
   using type = op::op_if<typename generate_pred<ast::none_of<nested...>>::type>;
 };
 
+/**
+ * Determines whether an AST is a quantifier which may accept a varying amount
+ * of input. Such quantifiers cannot be repeated by the ops of another
+ * quantifier, which never backtrack into a repetition, so are only supported
+ * where `normalise` collapses them into a single quantifier.
+ */
+template <typename ast> struct is_variable_quantifier : no {};
+
+template <typename nested>
+struct is_variable_quantifier<ast::zero_or_more<nested>> : yes {};
+
+template <std::size_t n, typename nested>
+struct is_variable_quantifier<ast::at_least<n, nested>> : yes {};
+
+template <std::size_t n, typename nested>
+struct is_variable_quantifier<ast::at_most<n, nested>> : yes {};
+
+template <typename nested, typename until>
+struct is_variable_quantifier<ast::until<nested, until>> : yes {};
+
+template <typename quantifier> struct generate_nested_quantifier {
+  static_assert(!is_variable_quantifier<quantifier>::value,
+                "Quantifiers of quantifiers are only supported where they "
+                "accept the same input as a single quantifier");
+};
+
+template <typename nested>
+struct generate_op<ast::zero_or_more<nested>>
+    : generate_nested_quantifier<ast::zero_or_more<nested>> {};
+
+template <std::size_t n, typename nested>
+struct generate_op<ast::at_least<n, nested>>
+    : generate_nested_quantifier<ast::at_least<n, nested>> {};
+
+template <std::size_t n, typename nested>
+struct generate_op<ast::at_most<n, nested>>
+    : generate_nested_quantifier<ast::at_most<n, nested>> {};
+
+template <typename... nested> struct generate_op<ast::sequence<nested...>> {
+  static_assert(!(is_variable_quantifier<nested>::value || ...),
+                "Quantifiers of quantifiers are only supported where they "
+                "accept the same input as a single quantifier");
+  using type = typename generate_ops<op::accept_sequence<>,
+                                     ast::sequence<nested...>>::type;
+};
+
+/**
+ * Generates the op accepting the `i`-th byte sequence of a UTF-8 class
+ */
+template <typename ast, std::size_t i,
+          typename bytes = std::make_index_sequence<
+              utf8_sequences_of<ast>::value.values[i].length>>
+struct generate_utf8_sequence;
+
+template <typename ast, std::size_t i, std::size_t... j>
+struct generate_utf8_sequence<ast, i, std::index_sequence<j...>> {
+  constexpr static const utf8::byte_sequence &sequence =
+      utf8_sequences_of<ast>::value.values[i];
+  using type = typename std::conditional<
+      sizeof...(j) == 1,
+      op::accept_range<static_cast<char>(sequence.lower[0]),
+                       static_cast<char>(sequence.upper[0])>,
+      op::accept_sequence<
+          op::accept_range<static_cast<char>(sequence.lower[j]),
+                           static_cast<char>(sequence.upper[j])>...>>::type;
+};
+
+template <typename ast, typename ascii, typename multibyte>
+struct generate_utf8;
+
+template <typename ast, std::size_t... i, std::size_t... j>
+struct generate_utf8<ast, std::index_sequence<i...>,
+                     std::index_sequence<j...>> {
+  using type = op::accept_utf8<
+      list<typename generate_utf8_sequence<ast, i>::type...>,
+      list<typename generate_utf8_sequence<ast, sizeof...(i) + j>::type...>>;
+};
+
+template <typename... ranges> struct generate_op<ast::utf8<ranges...>> {
+  constexpr static const utf8::byte_sequences &sequences =
+      utf8_sequences_of<ast::utf8<ranges...>>::value;
+  using type = typename generate_utf8<
+      ast::utf8<ranges...>,
+      std::make_index_sequence<sequences.single_bytes()>,
+      std::make_index_sequence<sequences.size -
+                               sequences.single_bytes()>>::type;
+};
+
 template <char c> struct generate_pred<ast::symbol<c>> {
   using type = pred::equals<c>;
 };
@@ -403,8 +791,22 @@ template <typename... nested> struct generate_pred<ast::none_of<nested...>> {
 
 } // anonymous namespace
 
+/**
+ * Generates the program of an optimised AST, which accepts only where the
+ * AST matches the whole of the input it is given
+ */
 template <typename ast> struct codegen_result {
   using type = typename generate_ops<op::accept_sequence<>, ast>::type;
 };
 
+/**
+ * Generates the program of an optimised AST for searching, which accepts the
+ * prefix of its input which quantifiers greedily extend furthest
+ */
+template <typename ast> struct prefix_codegen_result {
+  using type = typename generate_ops<op::accept_sequence<>, ast, yes>::type;
+};
+
 } // namespace scry
+
+#include "first.hpp"
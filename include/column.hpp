@@ -0,0 +1,53 @@
+#pragma once
+
+#include "definitions.hpp"
+#include "match.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace scry {
+
+/**
+ * Number of rows ahead of the current row whose first byte of data is
+ * prefetched by `filter_column`
+ */
+constexpr static const std::size_t column_prefetch_distance = 16;
+
+/**
+ * Determines whether each of the `n` values of a column of strings matches
+ * `regex`, setting bit `i % 64` of `bitmap[i / 64]` if value `i` matches. The
+ * column is laid out as in Apache Arrow: value `i` is the bytes
+ * [data + offsets[i], data + offsets[i + 1]), so `offsets` holds `n + 1`
+ * offsets of any integer type (e.g. `std::int32_t` or `std::int64_t`).
+ *
+ * Values are matched in place, so no strings are materialised, by the op
+ * program of `regex` inlined into the loop over rows. Ops may still call
+ * `memchr`, and sub-programs larger than `SCRY_INLINE_LIMIT`, if it is
+ * defined, are called through shared functions. While each row is matched,
+ * the cache line holding the first byte of the value `column_prefetch_distance`
+ * rows ahead is prefetched; `offsets` is read in order and is not prefetched.
+ * Unused bits of the last word are cleared, so on little-endian targets
+ * `bitmap` may be used directly as an Arrow selection bitmap.
+ *
+ * Note: `bitmap` must hold `(n + 63) / 64` words.
+ */
+template <typename regex, typename offset_type>
+void filter_column(const char *data, const offset_type *offsets, std::size_t n,
+                   std::uint64_t *bitmap) noexcept {
+  for (std::size_t word = 0; word < n; word += 64) {
+    const std::size_t last = word + 64 < n ? word + 64 : n;
+    std::uint64_t bits = 0;
+    for (std::size_t i = word; i < last; ++i) {
+      if (i + column_prefetch_distance < n) {
+        SCRY_PREFETCH(data + offsets[i + column_prefetch_distance]);
+      }
+      const bool matched = match_whole<regex>(data + offsets[i],
+                                              data + offsets[i + 1]);
+      bits |= std::uint64_t{matched} << (i - word);
+    }
+    bitmap[word / 64] = bits;
+  }
+}
+
+} // namespace scry
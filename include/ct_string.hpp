@@ -27,4 +27,21 @@ public:
   constexpr static size_type size = size_of_str(cs);
 };
 
+/**
+ * Compile-time string holding the characters `cs`, so that equal strings are
+ * the same type wherever they are declared
+ */
+template <char... cs> class fixed_string {
+
+public:
+  using size_type = std::size_t;
+
+  constexpr static char get(size_type index) { return chars[index]; }
+
+  constexpr static size_type size = sizeof...(cs);
+
+private:
+  constexpr static const char chars[sizeof...(cs) + 1] = {cs..., '\0'};
+};
+
 } // namespace scry
@@ -10,3 +10,52 @@
 #elif defined(_MSC_VER)
 #define SCRY_INLINE __forceinline inline
 #endif
+
+/**
+ * Custom specifier preventing inlining, used to outline large sub-programs
+ * into functions shared by every program containing them
+ */
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define SCRY_NOINLINE [[gnu::noinline]]
+#elif defined(_MSC_VER)
+#define SCRY_NOINLINE __declspec(noinline)
+#else
+#define SCRY_NOINLINE
+#endif
+
+/**
+ * Largest estimated size (see `op::program_size`) of a sub-program which is
+ * inlined into the op executing it. By default every op is inlined. Defining
+ * a limit (e.g. 24) before including scry executes larger sub-programs, such
+ * as the bodies and continuations of quantifiers early in long patterns,
+ * through a shared function instead, which bounds the size of the code
+ * generated for each pattern at the cost of a call per execution.
+ */
+#if !defined(SCRY_INLINE_LIMIT)
+#define SCRY_INLINE_LIMIT (~0ull)
+#endif
+
+/**
+ * Hint that the memory at an address will soon be read, so that it may be
+ * loaded into cache ahead of use
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define SCRY_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define SCRY_PREFETCH(address) static_cast<void>(address)
+#endif
+
+/**
+ * Determines whether the enclosing function may be being evaluated in a
+ * constant expression, so that runtime-only code (e.g. calls to `memchr` on
+ * reinterpreted pointers) can be skipped. Without compiler support this is
+ * conservatively always true.
+ */
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define SCRY_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#endif
+#if !defined(SCRY_CONSTANT_EVALUATED)
+#define SCRY_CONSTANT_EVALUATED() true
+#endif
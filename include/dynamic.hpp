@@ -0,0 +1,663 @@
+#pragma once
+
+#include "charset.hpp"
+#include "definitions.hpp"
+#include "optimise.hpp"
+#include "parser.hpp"
+#include "traits.hpp"
+#include "util.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace scry {
+
+namespace vm {
+
+/**
+ * Operations of the bytecode executed by `dynamic_regex`, each mirroring an op
+ * generated by codegen.hpp
+ */
+enum class opcode : std::uint8_t {
+  done,         // `op::accept_sequence<>`
+  accept,       // `op::accept_n`
+  zero_or_more, // `op::accept_zero_or_more`
+  at_most,      // `op::accept_at_most`
+  until_first,  // `op::accept_until` for "[^c]*c"
+  until_class,  // `op::accept_until` for classes which cannot accept c
+  until_last,   // `op::accept_until` for ".*c"
+  right_anchor, // `op::right_anchor`
+};
+
+/**
+ * Kinds of single-symbol operand accepted by an instruction
+ */
+enum class atom : std::uint8_t { symbol, any, set };
+
+/**
+ * Single instruction of a `dynamic_regex` program. The atom of an instruction
+ * is accepted `times` times per repetition (for brace expressions nested in
+ * quantifiers), and `count` is the bound of `at_most`. The `until_*`
+ * instructions stop at `terminator`.
+ */
+struct instruction {
+  opcode code{opcode::done};
+  atom kind{atom::any};
+  char symbol{0};
+  char terminator{0};
+  std::uint16_t set{0};
+  std::uint32_t times{1};
+  std::uint32_t count{0};
+};
+
+} // namespace vm
+
+/**
+ * Regex parsed from the basic grammar at runtime into a flat bytecode program,
+ * for patterns which are only known once the program has started. Quantifiers
+ * are normalised with the bounds arithmetic of optimise.hpp, so patterns which
+ * compile at compile-time compile here too, and programs are executed with
+ * the same semantics as the ops generated by codegen.hpp.
+ */
+class dynamic_regex {
+
+public:
+  /**
+   * Compiles `pattern`, returning nothing if the pattern is invalid
+   */
+  static maybe<dynamic_regex> compile(std::string_view pattern,
+                                      trait_type traits = trait::basic) {
+    constexpr trait_type all_grammars = trait::ECMAScript | trait::basic |
+                                        trait::extended | trait::awk |
+                                        trait::grep | trait::egrep;
+    const trait_type grammar = traits & all_grammars;
+    if (grammar != trait::ECMAScript && grammar != trait::basic &&
+        grammar != trait::extended && grammar != trait::awk &&
+        grammar != trait::grep && grammar != trait::egrep) {
+      return {};
+    }
+    // UTF-8 classes are only compiled at compile-time
+    if (traits & trait::utf8) {
+      return {};
+    }
+    dynamic_regex result;
+    std::vector<repetition> sequence;
+    if (!result.parse(pattern.data(), pattern.size(), sequence) ||
+        !result.generate(sequence)) {
+      return {};
+    }
+    result.optimise();
+    result.code.push_back(vm::instruction{});
+    return maybe<dynamic_regex>{std::move(result)};
+  }
+
+  /**
+   * Executes the program from `begin`, returning the end of the match
+   */
+  template <typename it_type>
+  maybe<it_type> execute(it_type begin, it_type end) const noexcept {
+    return run(code.data(), begin, end);
+  }
+
+  const std::vector<vm::instruction> &program() const noexcept { return code; }
+
+  const std::vector<char_set> &sets() const noexcept { return classes; }
+
+private:
+  std::vector<vm::instruction> code;
+  std::vector<char_set> classes;
+
+  /**
+   * Between `lower` and `upper` repetitions of `atom`, the form every element
+   * of a sequence takes while it is parsed (see `repetition` in optimise.hpp)
+   */
+  struct repetition {
+    vm::instruction atom;
+    std::size_t lower;
+    std::size_t upper;
+  };
+
+  /**
+   * Parsing, mirroring the grammar accepted by parser.hpp
+   */
+  bool parse(const char *pattern, std::size_t size,
+             std::vector<repetition> &sequence) {
+    for (std::size_t i = 0; i < size;) {
+      const char c = pattern[i];
+      if (c == '\\') {
+        if (i + 1 == size) {
+          return false;
+        }
+        const char escaped = pattern[i + 1];
+        if (escaped == '{') {
+          i += 2;
+          if (!parse_brace(pattern, size, i, sequence)) {
+            return false;
+          }
+          continue;
+        }
+        if (escaped != '.' && escaped != '\\' && escaped != '^' &&
+            escaped != '$') {
+          return false;
+        }
+        push_symbol(sequence, escaped);
+        i += 2;
+      } else if (c == '^' && i == 0) {
+        // A leading circumflex anchors to the beginning, which is implicit
+        ++i;
+        if (i < size && pattern[i] == '*') {
+          push_symbol(sequence, '*');
+          ++i;
+        }
+      } else if (c == '$' && i + 1 == size) {
+        vm::instruction anchor{};
+        anchor.code = vm::opcode::right_anchor;
+        push(sequence, anchor);
+        ++i;
+      } else if (c == '.') {
+        vm::instruction any{};
+        any.code = vm::opcode::accept;
+        any.kind = vm::atom::any;
+        push(sequence, any);
+        ++i;
+      } else if (c == '*') {
+        ++i;
+        if (sequence.empty()) {
+          push_symbol(sequence, '*');
+        } else if (!repeat(sequence.back(), 0, unbounded)) {
+          return false;
+        }
+      } else if (c == '[') {
+        ++i;
+        if (!parse_bracket(pattern, size, i, sequence)) {
+          return false;
+        }
+      } else {
+        push_symbol(sequence, c);
+        ++i;
+      }
+    }
+    join_last(sequence);
+    return true;
+  }
+
+  static bool same_atom(const vm::instruction &a,
+                        const vm::instruction &b) noexcept {
+    return a.kind == b.kind && a.times == b.times &&
+           (a.kind != vm::atom::symbol || a.symbol == b.symbol) &&
+           (a.kind != vm::atom::set || a.set == b.set);
+  }
+
+  /**
+   * Joins the last element of `sequence`, which can no longer be quantified,
+   * with the one before it. As `join` does, an element which accepts nothing
+   * is dropped and repetitions of the same atom are merged.
+   */
+  static void join_last(std::vector<repetition> &sequence) {
+    if (!sequence.empty() && sequence.back().upper == 0) {
+      sequence.pop_back();
+      return;
+    }
+    if (sequence.size() < 2) {
+      return;
+    }
+    repetition &left = sequence[sequence.size() - 2];
+    const repetition &right = sequence.back();
+    if (left.atom.code == vm::opcode::accept &&
+        right.atom.code == vm::opcode::accept &&
+        same_atom(left.atom, right.atom)) {
+      left.lower += right.lower;
+      left.upper = add_bounds(left.upper, right.upper);
+      sequence.pop_back();
+    }
+  }
+
+  static void push(std::vector<repetition> &sequence,
+                   const vm::instruction &atom) {
+    join_last(sequence);
+    sequence.push_back(repetition{atom, 1, 1});
+  }
+
+  static void push_symbol(std::vector<repetition> &sequence, char c) {
+    vm::instruction symbol{};
+    symbol.code = vm::opcode::accept;
+    symbol.kind = vm::atom::symbol;
+    symbol.symbol = c;
+    push(sequence, symbol);
+  }
+
+  /**
+   * Repeats `element` between `a` and `b` times, as `quantify` does. Returns
+   * false when a quantifier of a quantifier cannot be collapsed into one, which
+   * codegen.hpp rejects.
+   */
+  static bool repeat(repetition &element, std::size_t a, std::size_t b) {
+    if (element.atom.code != vm::opcode::accept) {
+      return false;
+    }
+    if (b == 0 || element.upper == 0) {
+      element.lower = 0;
+      element.upper = 0;
+    } else if (repetitions_collapse(a, b, element.lower, element.upper)) {
+      if (!fits(a, element.lower) ||
+          (b != unbounded && element.upper != unbounded &&
+           !fits(b, element.upper))) {
+        return false;
+      }
+      element.lower = multiply_bounds(a, element.lower);
+      element.upper = multiply_bounds(b, element.upper);
+    } else if (element.lower == element.upper &&
+               fits(element.lower, element.atom.times)) {
+      element.atom.times *= static_cast<std::uint32_t>(element.lower);
+      element.lower = a;
+      element.upper = b;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Determines whether `a * b` repetitions may be counted by an instruction
+   */
+  static bool fits(std::size_t a, std::size_t b) noexcept {
+    constexpr std::size_t limit = 0xFFFFFFFF;
+    return b == 0 || a <= limit / b;
+  }
+
+  /**
+   * Rewrites each element of a parsed sequence back into instructions, as
+   * `emit` does: the required repetitions, then `zero_or_more` or `at_most`
+   * for the optional ones
+   */
+  bool generate(const std::vector<repetition> &sequence) {
+    for (const repetition &element : sequence) {
+      vm::instruction instruction = element.atom;
+      if (instruction.code != vm::opcode::accept) {
+        code.push_back(instruction);
+        continue;
+      }
+      if (element.lower != 0) {
+        if (!fits(element.lower, instruction.times)) {
+          return false;
+        }
+        vm::instruction required = instruction;
+        required.times *= static_cast<std::uint32_t>(element.lower);
+        code.push_back(required);
+      }
+      if (element.upper == unbounded) {
+        instruction.code = vm::opcode::zero_or_more;
+        code.push_back(instruction);
+      } else if (element.upper != element.lower) {
+        if (!fits(element.upper - element.lower, 1)) {
+          return false;
+        }
+        instruction.code = vm::opcode::at_most;
+        instruction.count =
+            static_cast<std::uint32_t>(element.upper - element.lower);
+        code.push_back(instruction);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Parses a decimal number, disallowing leading zeroes as parser.hpp does
+   */
+  static bool parse_number(const char *pattern, std::size_t size,
+                           std::size_t &i, std::uint32_t &number) {
+    if (i == size || pattern[i] < '0' || pattern[i] > '9') {
+      return false;
+    }
+    number = 0;
+    const std::size_t first = i;
+    for (; i < size && pattern[i] >= '0' && pattern[i] <= '9'; ++i) {
+      if (i != first && number == 0) {
+        return false;
+      }
+      number = number * 10 + static_cast<std::uint32_t>(pattern[i] - '0');
+      if (number > 0xFFFF) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Parses a brace expression following '\{' and applies it to the previous
+   * element
+   */
+  bool parse_brace(const char *pattern, std::size_t size, std::size_t &i,
+                   std::vector<repetition> &sequence) {
+    std::uint32_t lower = 0;
+    std::uint32_t upper = 0;
+    bool bounded = true;
+    if (!parse_number(pattern, size, i, lower)) {
+      return false;
+    }
+    if (i < size && pattern[i] == ',') {
+      ++i;
+      bounded = i < size && pattern[i] != '\\';
+      if (bounded && !parse_number(pattern, size, i, upper)) {
+        return false;
+      }
+    } else {
+      upper = lower;
+    }
+    if (i + 1 >= size || pattern[i] != '\\' || pattern[i + 1] != '}') {
+      return false;
+    }
+    i += 2;
+    if (sequence.empty() || (bounded && upper < lower)) {
+      return false;
+    }
+    return repeat(sequence.back(), lower, bounded ? upper : unbounded);
+  }
+
+  /**
+   * Parses a bracket expression following '[' into a set
+   */
+  bool parse_bracket(const char *pattern, std::size_t size, std::size_t &i,
+                     std::vector<repetition> &sequence) {
+    char_set set{};
+    bool negate = false;
+    if (i < size && pattern[i] == '^') {
+      negate = true;
+      ++i;
+    }
+    if (i < size && (pattern[i] == ']' || pattern[i] == '-')) {
+      set.insert(pattern[i++]);
+    }
+    while (true) {
+      if (i == size) {
+        return false;
+      }
+      char c = pattern[i];
+      if (c == ']') {
+        ++i;
+        break;
+      }
+      if (c == '[' && i + 1 < size && pattern[i + 1] == ':') {
+        if (!parse_class(pattern, size, i, set)) {
+          return false;
+        }
+        continue;
+      }
+      if (c == '[' && i + 1 < size && pattern[i + 1] == '=') {
+        if (i + 4 >= size || pattern[i + 3] != '=' || pattern[i + 4] != ']') {
+          return false;
+        }
+        set.insert(pattern[i + 2]);
+        i += 5;
+        continue;
+      }
+      if (c == '[' && i + 1 < size && pattern[i + 1] == '.') {
+        // Collating symbols are not supported, see parser.hpp
+        return false;
+      }
+      if (c == '\\') {
+        if (i + 1 == size) {
+          return false;
+        }
+        c = pattern[i + 1];
+        i += 2;
+      } else {
+        ++i;
+      }
+      if (i + 1 < size && pattern[i] == '-' && pattern[i + 1] != ']') {
+        char upper = pattern[i + 1];
+        i += 2;
+        if (upper == '\\') {
+          if (i == size) {
+            return false;
+          }
+          upper = pattern[i++];
+        }
+        if (unit_value(upper) < unit_value(c)) {
+          return false;
+        }
+        set.insert(c, upper);
+      } else {
+        set.insert(c);
+      }
+    }
+    vm::instruction instruction{};
+    instruction.code = vm::opcode::accept;
+    instruction.kind = vm::atom::set;
+    instruction.set = intern(negate ? ~set : set);
+    push(sequence, instruction);
+    return true;
+  }
+
+  /**
+   * Parses a character class expression ('[:name:]') into `set`
+   */
+  static bool parse_class(const char *pattern, std::size_t size,
+                          std::size_t &i, char_set &set) {
+    struct named {
+      const char *name;
+      char_set value;
+    };
+    constexpr named names[] = {
+        {"upper", char_set_of<ast::cc::upper>::value},
+        {"lower", char_set_of<ast::cc::lower>::value},
+        {"alpha", char_set_of<ast::cc::alpha>::value},
+        {"digit", char_set_of<ast::cc::digit>::value},
+        {"xdigit", char_set_of<ast::cc::xdigit>::value},
+        {"alnum", char_set_of<ast::cc::alnum>::value},
+        {"punct", char_set_of<ast::cc::punct>::value},
+        {"blank", char_set_of<ast::cc::blank>::value},
+        {"space", char_set_of<ast::cc::space>::value},
+        {"cntrl", char_set_of<ast::cc::cntrl>::value},
+        {"graph", char_set_of<ast::cc::graph>::value},
+        {"print", char_set_of<ast::cc::print>::value},
+        {"word", char_set_of<ast::cc::word>::value},
+    };
+    const std::size_t first = i + 2;
+    std::size_t last = first;
+    while (last + 1 < size &&
+           !(pattern[last] == ':' && pattern[last + 1] == ']')) {
+      ++last;
+    }
+    if (last + 1 >= size) {
+      return false;
+    }
+    for (const named &candidate : names) {
+      if (std::strlen(candidate.name) == last - first &&
+          std::strncmp(candidate.name, pattern + first, last - first) == 0) {
+        set = set | candidate.value;
+        i = last + 2;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::uint16_t intern(const char_set &set) {
+    for (std::size_t i = 0; i < classes.size(); ++i) {
+      if (classes[i] == set) {
+        return static_cast<std::uint16_t>(i);
+      }
+    }
+    classes.push_back(set);
+    return static_cast<std::uint16_t>(classes.size() - 1);
+  }
+
+  /**
+   * Optimisation, applying the rewrites of optimise.hpp in the same order
+   */
+  void optimise() {
+    std::vector<vm::instruction> result;
+    result.reserve(code.size());
+    for (std::size_t i = 0; i < code.size(); ++i) {
+      vm::instruction current = code[i];
+      if (current.code == vm::opcode::zero_or_more && i + 1 < code.size()) {
+        const vm::instruction following = code[i + 1];
+        // "A*A" into "AA*"
+        if (following.code == vm::opcode::accept &&
+            same_atom(current, following)) {
+          result.push_back(following);
+          code[i + 1] = current;
+          continue;
+        }
+        // ".*c" and "X*c", where X cannot accept c, into `until`s
+        if (current.kind != vm::atom::symbol && current.times == 1 &&
+            following.code == vm::opcode::accept &&
+            following.kind == vm::atom::symbol && following.times == 1) {
+          const char c = following.symbol;
+          if (current.kind == vm::atom::any) {
+            current.code = vm::opcode::until_last;
+          } else if (classes[current.set] == ~char_set::of(c)) {
+            current.code = vm::opcode::until_first;
+          } else if (!classes[current.set].contains(c)) {
+            current.code = vm::opcode::until_class;
+          }
+          if (current.code != vm::opcode::zero_or_more) {
+            current.terminator = c;
+            result.push_back(current);
+            ++i;
+            continue;
+          }
+        }
+      }
+      result.push_back(current);
+    }
+    code = std::move(result);
+  }
+
+  /**
+   * Execution
+   */
+  template <typename it_type>
+  SCRY_INLINE bool step(const vm::instruction &instruction, it_type &begin,
+                        it_type end) const noexcept {
+    for (std::uint32_t i = 0; i < instruction.times; ++i) {
+      if (begin == end) {
+        return false;
+      }
+      switch (instruction.kind) {
+      case vm::atom::symbol:
+        if (*begin != instruction.symbol) {
+          return false;
+        }
+        break;
+      case vm::atom::any:
+        break;
+      case vm::atom::set:
+        if (!classes[instruction.set].contains(*begin)) {
+          return false;
+        }
+        break;
+      }
+      ++begin;
+    }
+    return true;
+  }
+
+  template <typename it_type>
+  maybe<it_type> run(const vm::instruction *pc, it_type begin,
+                     it_type end) const noexcept {
+    for (;; ++pc) {
+      switch (pc->code) {
+      case vm::opcode::done:
+        return begin;
+      case vm::opcode::accept:
+        if (!step(*pc, begin, end)) {
+          return {};
+        }
+        break;
+      case vm::opcode::right_anchor:
+        if (begin != end) {
+          return {};
+        }
+        break;
+      case vm::opcode::zero_or_more: {
+        if (pc[1].code == vm::opcode::done) {
+          while (begin != end) {
+            if (!step(*pc, begin, end)) {
+              return {};
+            }
+          }
+          return begin;
+        }
+        maybe<it_type> best = run(pc + 1, begin, end);
+        while (begin != end && !(best == end)) {
+          if (!step(*pc, begin, end)) {
+            return best;
+          }
+          if (auto it = run(pc + 1, begin, end)) {
+            best = it;
+          }
+        }
+        return best;
+      }
+      case vm::opcode::at_most: {
+        maybe<it_type> best = run(pc + 1, begin, end);
+        for (std::uint32_t i = 0; i < pc->count && !(best == end); ++i) {
+          if (!step(*pc, begin, end)) {
+            break;
+          }
+          if (auto it = run(pc + 1, begin, end)) {
+            best = it;
+          }
+        }
+        return best;
+      }
+      case vm::opcode::until_first:
+        begin = find_symbol(begin, end, pc->terminator);
+        if (begin == end) {
+          return {};
+        }
+        ++begin;
+        break;
+      case vm::opcode::until_class:
+        while (begin != end && *begin != pc->terminator) {
+          if (!classes[pc->set].contains(*begin)) {
+            return {};
+          }
+          ++begin;
+        }
+        if (begin == end) {
+          return {};
+        }
+        ++begin;
+        break;
+      case vm::opcode::until_last: {
+        maybe<it_type> best{};
+        while (!(best == end) &&
+               (begin = find_symbol(begin, end, pc->terminator)) != end) {
+          if (auto it = run(pc + 1, ++begin, end)) {
+            best = it;
+          }
+        }
+        return best;
+      }
+      }
+    }
+  }
+};
+
+template <typename it_type>
+bool regex_match(const dynamic_regex &regex, it_type begin,
+                 it_type end) noexcept {
+  static_assert(has_byte_units<it_type>::value,
+                "dynamic regexes can only match bytes");
+  auto result = regex.execute(begin, end);
+  return result && *result == end;
+}
+
+inline bool regex_match(const dynamic_regex &regex, const char *str) noexcept {
+  return regex_match(regex, str, str + std::strlen(str));
+}
+
+inline bool regex_match(const dynamic_regex &regex,
+                        const std::string &str) noexcept {
+  return regex_match(regex, str.begin(), str.end());
+}
+
+} // namespace scry
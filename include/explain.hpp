@@ -0,0 +1,621 @@
+#pragma once
+
+#include "codegen.hpp"
+#include "match.hpp"
+#include "optimise.hpp"
+#include "parser.hpp"
+#include "regex.hpp"
+
+#include <cstddef>
+#include <utility>
+
+namespace scry {
+
+namespace explain {
+
+/**
+ * Fixed-size null-terminated string rendered at compile-time
+ */
+template <std::size_t n> struct static_string {
+  char data[n + 1]{};
+  constexpr const char *c_str() const noexcept { return data; }
+  constexpr static std::size_t size() noexcept { return n; }
+};
+
+namespace {
+
+/**
+ * Writes text into `out`, or only measures it when `out` is null
+ */
+struct writer {
+  char *out{nullptr};
+  std::size_t size{0};
+
+  constexpr void put(char c) noexcept {
+    if (out) {
+      out[size] = c;
+    }
+    ++size;
+  }
+
+  constexpr void put(const char *cs) noexcept {
+    while (*cs != '\0') {
+      put(*cs++);
+    }
+  }
+
+  constexpr void put_number(std::size_t n) noexcept {
+    std::size_t scale = 1;
+    while (n / scale >= 10) {
+      scale *= 10;
+    }
+    for (; scale > 0; scale /= 10) {
+      put(static_cast<char>('0' + (n / scale) % 10));
+    }
+  }
+
+  constexpr void put_symbol(char c) noexcept {
+    constexpr const char *digits = "0123456789abcdef";
+    const unsigned char u = static_cast<unsigned char>(c);
+    put('\'');
+    if (c == '\'' || c == '\\') {
+      put('\\');
+      put(c);
+    } else if (c == '\t') {
+      put("\\t");
+    } else if (c == '\n') {
+      put("\\n");
+    } else if (c == '\r') {
+      put("\\r");
+    } else if (u < 0x20 || u >= 0x7F) {
+      put("\\x");
+      put(digits[u >> 4]);
+      put(digits[u & 0xF]);
+    } else {
+      put(c);
+    }
+    put('\'');
+  }
+
+  constexpr void put_range(char lower, char upper) noexcept {
+    put_symbol(lower);
+    put('-');
+    put_symbol(upper);
+  }
+
+  constexpr void put_code_point(char32_t c) noexcept {
+    constexpr const char *digits = "0123456789ABCDEF";
+    put("U+");
+    std::size_t shift = c > 0xFFFF ? 20 : 12;
+    for (;; shift -= 4) {
+      put(digits[(c >> shift) & 0xF]);
+      if (shift == 0) {
+        break;
+      }
+    }
+  }
+
+  constexpr void put_complexity(std::size_t exponent) noexcept {
+    if (exponent == 0) {
+      put("O(1)");
+    } else if (exponent == 1) {
+      put("O(n)");
+    } else {
+      put("O(n^");
+      put_number(exponent);
+      put(')');
+    }
+  }
+
+  constexpr void indent(std::size_t depth) noexcept {
+    for (std::size_t i = 0; i < depth; ++i) {
+      put("  ");
+    }
+  }
+};
+
+constexpr std::size_t max_of(std::size_t a, std::size_t b) noexcept {
+  return a < b ? b : a;
+}
+
+/**
+ * Estimated worst-case complexity of an op, as the exponent of the input
+ * length. Quantifiers which probe their `next` op after every iteration
+ * multiply its cost by the input length, whereas bounded repetitions only
+ * multiply it by a constant.
+ */
+template <typename op> struct cost {
+  constexpr static const std::size_t value = 0;
+};
+
+template <typename... ops> constexpr std::size_t max_cost() noexcept {
+  std::size_t result = 0;
+  ((result = max_of(result, cost<ops>::value)), ...);
+  return result;
+}
+
+template <typename... ops> struct cost<op::accept_sequence<ops...>> {
+  constexpr static const std::size_t value = max_cost<ops...>();
+};
+
+template <typename nested, typename next>
+struct cost<op::accept_zero_or_more<nested, next>> {
+  constexpr static const std::size_t value = 1 + max_cost<nested, next>();
+};
+
+template <typename nested> struct cost<op::accept_trailing<nested>> {
+  constexpr static const std::size_t value = 1 + cost<nested>::value;
+};
+
+template <typename nested, typename until, typename next>
+struct cost<op::accept_until<nested, until, next>> {
+  constexpr static const std::size_t value =
+      max_of(1 + max_cost<nested, until>(), cost<next>::value);
+};
+
+template <char c, typename next>
+struct cost<op::accept_until<op::op_if<pred::negate<pred::equals<c>>>,
+                             op::accept<c>, next>> {
+  constexpr static const std::size_t value = max_of(1, cost<next>::value);
+};
+
+template <char c, typename next>
+struct cost<op::accept_until<op::accept_any, op::accept<c>, next>> {
+  constexpr static const std::size_t value = 1 + cost<next>::value;
+};
+
+template <std::size_t n, typename nested>
+struct cost<op::accept_n<n, nested>> {
+  constexpr static const std::size_t value = cost<nested>::value;
+};
+
+template <std::size_t n, typename nested, typename next>
+struct cost<op::accept_at_most<n, nested, next>> {
+  constexpr static const std::size_t value = max_cost<nested, next>();
+};
+
+/**
+ * Renders a node of an AST or op program as an indented tree, one node per
+ * line. The caller writes the indentation of the first line.
+ */
+template <typename node> struct printer;
+
+template <typename node>
+constexpr void print_child(writer &w, std::size_t depth,
+                           const char *role = "") noexcept {
+  w.indent(depth);
+  w.put(role);
+  printer<node>::print(w, depth);
+}
+
+template <typename... nested>
+constexpr void print_children(writer &w,
+                              [[maybe_unused]] std::size_t depth) noexcept {
+  (print_child<nested>(w, depth), ...);
+}
+
+/**
+ * Renders a predicate on a single line
+ */
+template <typename pred> struct pred_printer;
+
+template <char c> struct pred_printer<pred::equals<c>> {
+  constexpr static void print(writer &w) noexcept { w.put_symbol(c); }
+};
+
+template <char lower, char upper>
+struct pred_printer<pred::in_range<lower, upper>> {
+  constexpr static void print(writer &w) noexcept {
+    w.put_range(lower, upper);
+  }
+};
+
+template <typename nested> struct pred_printer<pred::negate<nested>> {
+  constexpr static void print(writer &w) noexcept {
+    w.put("not(");
+    pred_printer<nested>::print(w);
+    w.put(')');
+  }
+};
+
+template <typename left, typename right>
+struct pred_printer<pred::left_or_right<left, right>> {
+  constexpr static void print(writer &w) noexcept {
+    pred_printer<left>::print(w);
+    w.put(" | ");
+    pred_printer<right>::print(w);
+  }
+};
+
+template <typename left, typename right>
+struct pred_printer<pred::left_and_right<left, right>> {
+  constexpr static void print(writer &w) noexcept {
+    pred_printer<left>::print(w);
+    w.put(" & ");
+    pred_printer<right>::print(w);
+  }
+};
+
+/**
+ * Printers for AST nodes
+ */
+template <typename... nested> struct printer<ast::sequence<nested...>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("sequence\n");
+    print_children<nested...>(w, depth + 1);
+  }
+};
+
+template <char c> struct printer<ast::symbol<c>> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("symbol ");
+    w.put_symbol(c);
+    w.put('\n');
+  }
+};
+
+template <> struct printer<ast::any> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("any\n");
+  }
+};
+
+template <> struct printer<ast::never> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("never\n");
+  }
+};
+
+template <> struct printer<ast::left_anchor> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("left_anchor\n");
+  }
+};
+
+template <> struct printer<ast::right_anchor> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("right_anchor\n");
+  }
+};
+
+template <char lower, char upper> struct printer<ast::range<lower, upper>> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("range ");
+    w.put_range(lower, upper);
+    w.put('\n');
+  }
+};
+
+template <char32_t lower, char32_t upper>
+struct printer<ast::code_points<lower, upper>> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("code_points ");
+    w.put_code_point(lower);
+    w.put('-');
+    w.put_code_point(upper);
+    w.put('\n');
+  }
+};
+
+template <typename... ranges> struct printer<ast::utf8<ranges...>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("utf8\n");
+    print_children<ranges...>(w, depth + 1);
+  }
+};
+
+template <typename nested> struct printer<ast::zero_or_more<nested>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("zero_or_more\n");
+    print_child<nested>(w, depth + 1);
+  }
+};
+
+template <std::size_t n, typename nested>
+struct printer<ast::exactly<n, nested>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("exactly ");
+    w.put_number(n);
+    w.put('\n');
+    print_child<nested>(w, depth + 1);
+  }
+};
+
+template <std::size_t n, typename nested>
+struct printer<ast::at_least<n, nested>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("at_least ");
+    w.put_number(n);
+    w.put('\n');
+    print_child<nested>(w, depth + 1);
+  }
+};
+
+template <std::size_t n, typename nested>
+struct printer<ast::at_most<n, nested>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("at_most ");
+    w.put_number(n);
+    w.put('\n');
+    print_child<nested>(w, depth + 1);
+  }
+};
+
+template <typename... nested> struct printer<ast::any_of<nested...>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("any_of\n");
+    print_children<nested...>(w, depth + 1);
+  }
+};
+
+template <typename... nested> struct printer<ast::none_of<nested...>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("none_of\n");
+    print_children<nested...>(w, depth + 1);
+  }
+};
+
+template <typename nested, typename until>
+struct printer<ast::until<nested, until>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("until\n");
+    print_child<nested>(w, depth + 1);
+    print_child<until>(w, depth + 1);
+  }
+};
+
+/**
+ * Printers for ops, where quantifiers are annotated with their estimated
+ * worst-case complexity
+ */
+template <typename op> constexpr void put_cost(writer &w) noexcept {
+  w.put("  [");
+  w.put_complexity(cost<op>::value);
+  w.put("]\n");
+}
+
+template <typename... ops> struct printer<op::accept_sequence<ops...>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("accept_sequence\n");
+    print_children<ops...>(w, depth + 1);
+  }
+};
+
+template <char c> struct printer<op::accept<c>> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("accept ");
+    w.put_symbol(c);
+    w.put('\n');
+  }
+};
+
+template <char c> struct printer<op::reject<c>> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("reject ");
+    w.put_symbol(c);
+    w.put('\n');
+  }
+};
+
+template <> struct printer<op::accept_any> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("accept_any\n");
+  }
+};
+
+template <> struct printer<op::accept_nothing> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("accept_nothing\n");
+  }
+};
+
+template <> struct printer<op::left_anchor> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("left_anchor\n");
+  }
+};
+
+template <> struct printer<op::right_anchor> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("right_anchor\n");
+  }
+};
+
+template <char lower, char upper>
+struct printer<op::accept_range<lower, upper>> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("accept_range ");
+    w.put_range(lower, upper);
+    w.put('\n');
+  }
+};
+
+template <char lower, char upper>
+struct printer<op::reject_range<lower, upper>> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("reject_range ");
+    w.put_range(lower, upper);
+    w.put('\n');
+  }
+};
+
+template <typename nested> struct printer<op::op_if<nested>> {
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("op_if ");
+    pred_printer<nested>::print(w);
+    w.put('\n');
+  }
+};
+
+template <typename... ascii, typename... multibyte>
+struct printer<op::accept_utf8<list<ascii...>, list<multibyte...>>> {
+  constexpr static void print(writer &w,
+                              [[maybe_unused]] std::size_t depth) noexcept {
+    w.put("accept_utf8\n");
+    (print_child<ascii>(w, depth + 1, "ascii: "), ...);
+    (print_child<multibyte>(w, depth + 1, "multibyte: "), ...);
+  }
+};
+
+template <typename nested, typename next>
+struct printer<op::accept_zero_or_more<nested, next>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("accept_zero_or_more");
+    put_cost<op::accept_zero_or_more<nested, next>>(w);
+    print_child<nested>(w, depth + 1, "nested: ");
+    print_child<next>(w, depth + 1, "next: ");
+  }
+};
+
+template <typename nested> struct printer<op::accept_trailing<nested>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("accept_trailing");
+    put_cost<op::accept_trailing<nested>>(w);
+    print_child<nested>(w, depth + 1, "nested: ");
+  }
+};
+
+template <typename nested, typename until, typename next>
+struct printer<op::accept_until<nested, until, next>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("accept_until");
+    put_cost<op::accept_until<nested, until, next>>(w);
+    print_child<nested>(w, depth + 1, "nested: ");
+    print_child<until>(w, depth + 1, "until: ");
+    print_child<next>(w, depth + 1, "next: ");
+  }
+};
+
+template <char c, typename next>
+struct printer<op::accept_until<op::op_if<pred::negate<pred::equals<c>>>,
+                                op::accept<c>, next>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("accept_until first ");
+    w.put_symbol(c);
+    w.put(" (memchr)");
+    put_cost<op::accept_until<op::op_if<pred::negate<pred::equals<c>>>,
+                              op::accept<c>, next>>(w);
+    print_child<next>(w, depth + 1, "next: ");
+  }
+};
+
+template <char c, typename next>
+struct printer<op::accept_until<op::accept_any, op::accept<c>, next>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("accept_until last ");
+    w.put_symbol(c);
+    w.put(" (memchr)");
+    put_cost<op::accept_until<op::accept_any, op::accept<c>, next>>(w);
+    print_child<next>(w, depth + 1, "next: ");
+  }
+};
+
+template <std::size_t n, typename nested>
+struct printer<op::accept_n<n, nested>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("accept_n ");
+    w.put_number(n);
+    w.put('\n');
+    print_child<nested>(w, depth + 1, "nested: ");
+  }
+};
+
+template <std::size_t n, typename nested, typename next>
+struct printer<op::accept_at_most<n, nested, next>> {
+  constexpr static void print(writer &w, std::size_t depth) noexcept {
+    w.put("accept_at_most ");
+    w.put_number(n);
+    put_cost<op::accept_at_most<n, nested, next>>(w);
+    print_child<nested>(w, depth + 1, "nested: ");
+    print_child<next>(w, depth + 1, "next: ");
+  }
+};
+
+/**
+ * Renders a node into a `static_string`, measuring it first to determine the
+ * size of the string
+ */
+template <typename node> constexpr std::size_t measure() noexcept {
+  writer w{};
+  printer<node>::print(w, 0);
+  return w.size;
+}
+
+template <typename node> constexpr auto render() noexcept {
+  static_string<measure<node>()> result{};
+  writer w{result.data};
+  printer<node>::print(w, 0);
+  return result;
+}
+
+/**
+ * The stages of compiling `regex` to match strings, whose op program is the
+ * one `regex_match` executes and so is compiled in reverse when
+ * `match_program` prefers it
+ */
+template <typename regex> struct stages : match_program<regex, const char *> {};
+
+/**
+ * Renders the pattern, each stage of compilation, and the overall estimated
+ * worst-case complexity of a regex
+ */
+template <typename regex> struct plan_printer {
+  using stage = stages<regex>;
+  constexpr static void print(writer &w, std::size_t) noexcept {
+    w.put("pattern: ");
+    for (std::size_t i = 0; i < regex::string::size; ++i) {
+      w.put(regex::string::get(i));
+    }
+    w.put("\nparse:\n");
+    print_child<typename stage::tree>(w, 1);
+    w.put("optimise:\n");
+    print_child<typename stage::opt_tree>(w, 1);
+    w.put(stage::reversed ? "codegen (reversed):\n" : "codegen:\n");
+    print_child<typename stage::code>(w, 1);
+    w.put("complexity: ");
+    w.put_complexity(cost<typename stage::code>::value);
+    w.put('\n');
+  }
+};
+
+template <const char *cs, const trait_type traits>
+struct printer<regex<cs, traits>> : plan_printer<regex<cs, traits>> {};
+
+template <const trait_type traits, char... cs>
+struct printer<fixed_regex<traits, cs...>>
+    : plan_printer<fixed_regex<traits, cs...>> {};
+
+} // anonymous namespace
+
+/**
+ * Renders the AST produced by parsing `regex`
+ */
+template <typename regex> constexpr auto parse_tree() noexcept {
+  return render<typename stages<regex>::tree>();
+}
+
+/**
+ * Renders the AST produced by optimising `regex`
+ */
+template <typename regex> constexpr auto optimised_tree() noexcept {
+  return render<typename stages<regex>::opt_tree>();
+}
+
+/**
+ * Renders the op program `regex_match` executes for `regex` on strings
+ */
+template <typename regex> constexpr auto program() noexcept {
+  return render<typename stages<regex>::code>();
+}
+
+/**
+ * Renders every stage of compiling `regex`, along with the estimated
+ * worst-case complexity of each quantifier and of the whole program
+ */
+template <typename regex> constexpr auto plan() noexcept {
+  return render<regex>();
+}
+
+} // namespace explain
+
+} // namespace scry
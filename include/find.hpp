@@ -0,0 +1,130 @@
+#pragma once
+
+#include "search.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+#if __cplusplus >= 202002L && __has_include(<ranges>)
+#include <ranges>
+#endif
+
+namespace scry {
+
+/**
+ * Iterates over the non-overlapping matches of `regex`, searching for each
+ * match from the end of the previous one (or one symbol past it, if it was
+ * empty). A default-constructed iterator is past the last match.
+ */
+template <typename regex, typename it_type> class regex_iterator {
+
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = sub_match<it_type>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type *;
+  using reference = const value_type &;
+
+  constexpr regex_iterator() noexcept = default;
+
+  constexpr regex_iterator(it_type begin, it_type end) noexcept
+      : first{begin}, last{end},
+        current{search_from<regex>(begin, begin, end)} {}
+
+  constexpr reference operator*() const noexcept { return current; }
+  constexpr pointer operator->() const noexcept { return &current; }
+
+  constexpr regex_iterator &operator++() noexcept {
+    it_type begin = current.end;
+    if (current.begin == current.end) {
+      if (begin == last) {
+        current = {};
+        return *this;
+      }
+      ++begin;
+    }
+    current = search_from<regex>(first, begin, last);
+    return *this;
+  }
+
+  constexpr regex_iterator operator++(int) noexcept {
+    regex_iterator result = *this;
+    ++*this;
+    return result;
+  }
+
+  friend constexpr bool operator==(const regex_iterator &left,
+                                   const regex_iterator &right) noexcept {
+    if (!left.current || !right.current) {
+      return !left.current && !right.current;
+    }
+    return left.current.begin == right.current.begin &&
+           left.current.end == right.current.end;
+  }
+
+  friend constexpr bool operator!=(const regex_iterator &left,
+                                   const regex_iterator &right) noexcept {
+    return !(left == right);
+  }
+
+private:
+  it_type first{};
+  it_type last{};
+  value_type current{};
+};
+
+/**
+ * Range of the non-overlapping matches of `regex` in [first, last), which
+ * are found lazily as the range is iterated
+ */
+template <typename regex, typename it_type>
+class regex_range
+#if __cplusplus >= 202002L && __has_include(<ranges>)
+    : public std::ranges::view_base
+#endif
+{
+
+public:
+  using iterator = regex_iterator<regex, it_type>;
+
+  constexpr regex_range() noexcept = default;
+
+  constexpr regex_range(it_type first, it_type last) noexcept
+      : first{first}, last{last} {}
+
+  constexpr iterator begin() const noexcept { return {first, last}; }
+  constexpr iterator end() const noexcept { return {}; }
+
+private:
+  it_type first{};
+  it_type last{};
+};
+
+/**
+ * Finds every non-overlapping match of `regex` in [begin, end) lazily
+ */
+template <typename regex, typename it_type>
+constexpr regex_range<regex, it_type> regex_find_all(it_type begin,
+                                                     it_type end) noexcept {
+  return {begin, end};
+}
+
+template <typename regex>
+constexpr regex_range<regex, const char *>
+regex_find_all(std::string_view str) noexcept {
+  return {str.data(), str.data() + str.size()};
+}
+
+} // namespace scry
+
+#if __cplusplus >= 202002L && __has_include(<ranges>)
+/**
+ * Matches refer to the searched input rather than to the range, so they
+ * remain valid after the range is destroyed
+ */
+template <typename regex, typename it_type>
+inline constexpr bool
+    std::ranges::enable_borrowed_range<scry::regex_range<regex, it_type>> =
+        true;
+#endif
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "charset.hpp"
+#include "codegen.hpp"
+
+#include <cstddef>
+
+namespace scry {
+
+namespace {
+
+/**
+ * Determines the FIRST set of an op: the symbols which may start input it
+ * accepts, and whether it may accept without consuming any input
+ *
+ * Note: Anchors are treated as accepting the empty string, so an op which may
+ *       only match at an anchor is nullable rather than having an empty FIRST
+ *       set.
+ */
+template <typename op> struct first_of;
+
+/**
+ * Determines the set of symbols accepted by an op which accepts exactly one
+ * symbol, by executing it on every symbol
+ */
+template <typename op> constexpr char_set symbols_of() noexcept {
+  char_set result{};
+  for (unsigned value = 0; value < 256; ++value) {
+    const char c[1] = {static_cast<char>(value)};
+    if (op::execute(c, c + 1)) {
+      result.insert(c[0]);
+    }
+  }
+  return result;
+}
+
+template <typename op> struct first_of_symbol {
+  constexpr static const char_set value = symbols_of<op>();
+  constexpr static const bool nullable = false;
+};
+
+/**
+ * FIRST set of `nested` followed by `next`, where `nested` may be repeated or
+ * skipped
+ */
+template <typename nested, typename next> struct first_of_optional {
+  constexpr static const char_set value =
+      first_of<nested>::value | first_of<next>::value;
+  constexpr static const bool nullable = first_of<next>::nullable;
+};
+
+template <> struct first_of<op::accept_sequence<>> {
+  constexpr static const char_set value{};
+  constexpr static const bool nullable = true;
+};
+
+template <typename head, typename... tail>
+struct first_of<op::accept_sequence<head, tail...>> {
+  constexpr static const char_set value =
+      first_of<head>::nullable
+          ? first_of<head>::value |
+                first_of<op::accept_sequence<tail...>>::value
+          : first_of<head>::value;
+  constexpr static const bool nullable =
+      first_of<head>::nullable &&
+      first_of<op::accept_sequence<tail...>>::nullable;
+};
+
+template <char c>
+struct first_of<op::accept<c>> : first_of_symbol<op::accept<c>> {};
+
+template <char c>
+struct first_of<op::reject<c>> : first_of_symbol<op::reject<c>> {};
+
+template <>
+struct first_of<op::accept_any> : first_of_symbol<op::accept_any> {};
+
+template <char lower, char upper>
+struct first_of<op::accept_range<lower, upper>>
+    : first_of_symbol<op::accept_range<lower, upper>> {};
+
+template <char lower, char upper>
+struct first_of<op::reject_range<lower, upper>>
+    : first_of_symbol<op::reject_range<lower, upper>> {};
+
+template <typename pred>
+struct first_of<op::op_if<pred>> : first_of_symbol<op::op_if<pred>> {};
+
+template <typename nested, typename next>
+struct first_of<op::accept_zero_or_more<nested, next>>
+    : first_of_optional<nested, next> {};
+
+template <typename nested>
+struct first_of<op::accept_trailing<nested>>
+    : first_of_optional<nested, op::accept_sequence<>> {};
+
+template <std::size_t n, typename nested, typename next>
+struct first_of<op::accept_at_most<n, nested, next>>
+    : first_of_optional<nested, next> {};
+
+template <typename nested, typename until, typename next>
+struct first_of<op::accept_until<nested, until, next>> {
+  constexpr static const char_set value =
+      first_of<nested>::value | first_of<until>::value;
+  constexpr static const bool nullable = false;
+};
+
+template <std::size_t n, typename nested>
+struct first_of<op::accept_n<n, nested>> {
+  constexpr static const char_set value =
+      n == 0 ? char_set{} : first_of<nested>::value;
+  constexpr static const bool nullable = n == 0 || first_of<nested>::nullable;
+};
+
+template <typename... ascii, typename... multibyte>
+struct first_of<op::accept_utf8<list<ascii...>, list<multibyte...>>> {
+  constexpr static const char_set value =
+      (char_set{} | ... | first_of<ascii>::value) |
+      (char_set{} | ... | first_of<multibyte>::value);
+  constexpr static const bool nullable = false;
+};
+
+template <> struct first_of<op::accept_nothing> {
+  constexpr static const char_set value{};
+  constexpr static const bool nullable = false;
+};
+
+template <> struct first_of<op::left_anchor> {
+  constexpr static const char_set value{};
+  constexpr static const bool nullable = true;
+};
+
+template <> struct first_of<op::right_anchor> {
+  constexpr static const char_set value{};
+  constexpr static const bool nullable = true;
+};
+
+/**
+ * Bounds of the FIRST set of an op by unsigned value, and whether the set is
+ * every symbol between them, in which case it may be tested with a single
+ * range comparison rather than a table lookup
+ */
+template <typename op> struct first_bounds {
+  constexpr static unsigned bound(bool upper) noexcept {
+    unsigned result = upper ? 0 : 255;
+    for (unsigned value = 0; value < 256; ++value) {
+      if (first_of<op>::value.contains(static_cast<char>(value))) {
+        result = upper ? value : (result < value ? result : value);
+      }
+    }
+    return result;
+  }
+  constexpr static const unsigned lower = bound(false);
+  constexpr static const unsigned upper = bound(true);
+  constexpr static const bool contiguous =
+      lower <= upper && first_of<op>::value.count() == upper - lower + 1;
+};
+
+template <typename op, typename it_type>
+SCRY_INLINE constexpr bool may_start(it_type begin, it_type end) noexcept {
+  constexpr const char_set &first = first_of<op>::value;
+  if constexpr (!has_byte_units<it_type>::value || first_of<op>::nullable ||
+                first == char_set::all()) {
+    return true;
+  } else if constexpr (first_bounds<op>::contiguous) {
+    return begin != end &&
+           ((first_bounds<op>::lower <= unit_value(*begin)) &
+            (unit_value(*begin) <= first_bounds<op>::upper));
+  } else {
+    return begin != end && first.contains(static_cast<char>(*begin));
+  }
+}
+
+/**
+ * Skips to the first position in [begin, end) at which an op with the given
+ * FIRST set may match, using `memchr` when the set has a single symbol
+ *
+ * Note: FIRST sets only describe bytes, so wider input is never skipped.
+ */
+template <typename op, typename it_type>
+SCRY_INLINE constexpr it_type skip_to_first(it_type begin,
+                                            it_type end) noexcept {
+  constexpr const char_set &first = first_of<op>::value;
+  if constexpr (!has_byte_units<it_type>::value || first_of<op>::nullable ||
+                first == char_set::all()) {
+    return begin;
+  } else if constexpr (first.count() == 1) {
+    constexpr char symbol = [] {
+      unsigned value = 0;
+      while (!first_of<op>::value.contains(static_cast<char>(value))) {
+        ++value;
+      }
+      return static_cast<char>(value);
+    }();
+    return find_symbol(begin, end, symbol);
+  } else {
+    while (begin != end && !first.contains(static_cast<char>(*begin))) {
+      ++begin;
+    }
+    return begin;
+  }
+}
+
+} // anonymous namespace
+
+} // namespace scry
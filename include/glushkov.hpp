@@ -0,0 +1,427 @@
+#pragma once
+
+#include "charset.hpp"
+#include "optimise.hpp"
+#include "parser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace scry {
+
+/**
+ * Fixed-size set of positions of a Glushkov automaton
+ */
+template <std::size_t bits> struct bit_set {
+  constexpr static const std::size_t size = (bits + 63) / 64;
+
+  std::uint64_t words[size]{};
+
+  constexpr bool test(std::size_t i) const noexcept {
+    return (words[i >> 6] >> (i & 63)) & 1;
+  }
+
+  constexpr void set(std::size_t i) noexcept {
+    words[i >> 6] |= std::uint64_t{1} << (i & 63);
+  }
+
+  constexpr bool any() const noexcept {
+    for (std::size_t i = 0; i < size; ++i) {
+      if (words[i] != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  constexpr bit_set &operator|=(const bit_set &other) noexcept {
+    for (std::size_t i = 0; i < size; ++i) {
+      words[i] |= other.words[i];
+    }
+    return *this;
+  }
+
+  constexpr bit_set operator&(const bit_set &other) const noexcept {
+    bit_set result{};
+    for (std::size_t i = 0; i < size; ++i) {
+      result.words[i] = words[i] & other.words[i];
+    }
+    return result;
+  }
+
+  constexpr bool operator==(const bit_set &other) const noexcept {
+    for (std::size_t i = 0; i < size; ++i) {
+      if (words[i] != other.words[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Calls `f` with the index of every position in the set
+   */
+  template <typename function>
+  constexpr void for_each(function &&f) const noexcept {
+    for (std::size_t i = 0; i < size; ++i) {
+      for (std::uint64_t word = words[i]; word != 0; word &= word - 1) {
+        std::size_t bit = 0;
+        for (std::uint64_t low = word & (~word + 1); low > 1; low >>= 1) {
+          ++bit;
+        }
+        f(i * 64 + bit);
+      }
+    }
+  }
+};
+
+/**
+ * Glushkov (position) automaton of an AST. Every symbol-accepting node of the
+ * AST is a position, and position 0 is the initial position. Entering a
+ * position requires accepting one of its `symbols`, so the automaton has no
+ * epsilon transitions and moves between sets of positions with
+ *
+ *   next = (union of follow[p] for p in current) & by_symbol[c]
+ *
+ * Anchors may only occur at the ends of a pattern and so are recorded as
+ * flags rather than positions. When several patterns share an automaton, each
+ * position records the index of the pattern it belongs to in `token`.
+ */
+template <std::size_t n> struct glushkov {
+  using set_type = bit_set<n>;
+
+  constexpr static const std::size_t size = n;
+
+  char_set symbols[n]{};
+  set_type follow[n]{};
+  set_type by_symbol[256]{};
+  set_type last{};
+  std::uint16_t token[n]{};
+  bool left_anchored{false};
+  bool right_anchored{false};
+};
+
+namespace {
+
+/**
+ * Counts the positions of an AST
+ */
+template <typename ast> struct position_count {
+  constexpr static const std::size_t value = 1;
+};
+
+template <typename... nested> struct position_count<ast::sequence<nested...>> {
+  constexpr static const std::size_t value =
+      (std::size_t{0} + ... + position_count<nested>::value);
+};
+
+template <> struct position_count<ast::left_anchor> {
+  constexpr static const std::size_t value = 0;
+};
+
+template <> struct position_count<ast::right_anchor> {
+  constexpr static const std::size_t value = 0;
+};
+
+template <> struct position_count<ast::never> {
+  constexpr static const std::size_t value = 0;
+};
+
+template <typename nested> struct position_count<ast::zero_or_more<nested>> {
+  constexpr static const std::size_t value = position_count<nested>::value;
+};
+
+template <std::size_t n, typename nested>
+struct position_count<ast::exactly<n, nested>> {
+  constexpr static const std::size_t value = n * position_count<nested>::value;
+};
+
+template <std::size_t n, typename nested>
+struct position_count<ast::at_least<n, nested>> {
+  constexpr static const std::size_t value =
+      (n + 1) * position_count<nested>::value;
+};
+
+template <std::size_t n, typename nested>
+struct position_count<ast::at_most<n, nested>> {
+  constexpr static const std::size_t value = n * position_count<nested>::value;
+};
+
+template <typename nested, typename until>
+struct position_count<ast::until<nested, until>> {
+  constexpr static const std::size_t value =
+      position_count<nested>::value + position_count<until>::value;
+};
+
+template <typename... ranges> struct position_count<ast::utf8<ranges...>> {
+  constexpr static std::size_t count() noexcept {
+    const utf8::byte_sequences &sequences =
+        utf8_sequences_of<ast::utf8<ranges...>>::value;
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < sequences.size; ++i) {
+      result += sequences.values[i].length;
+    }
+    return result;
+  }
+  constexpr static const std::size_t value = count();
+};
+
+/**
+ * First and last positions of a sub-expression, and whether it accepts the
+ * empty string
+ */
+template <std::size_t n> struct fragment {
+  bit_set<n> first{};
+  bit_set<n> last{};
+  bool nullable{true};
+};
+
+template <std::size_t n> struct builder {
+  glushkov<n> automaton{};
+  std::size_t next{1};
+
+  constexpr fragment<n> atom(const char_set &symbols) noexcept {
+    const std::size_t position = next++;
+    automaton.symbols[position] = symbols;
+    fragment<n> result{};
+    result.first.set(position);
+    result.last.set(position);
+    result.nullable = false;
+    return result;
+  }
+
+  constexpr fragment<n> concat(const fragment<n> &left,
+                               const fragment<n> &right) noexcept {
+    left.last.for_each(
+        [&](std::size_t p) { automaton.follow[p] |= right.first; });
+    fragment<n> result{left.first, right.last,
+                       left.nullable && right.nullable};
+    if (left.nullable) {
+      result.first |= right.first;
+    }
+    if (right.nullable) {
+      result.last |= left.last;
+    }
+    return result;
+  }
+
+  constexpr fragment<n> alternate(const fragment<n> &left,
+                                  const fragment<n> &right) noexcept {
+    fragment<n> result = left;
+    result.first |= right.first;
+    result.last |= right.last;
+    result.nullable = left.nullable || right.nullable;
+    return result;
+  }
+
+  constexpr fragment<n> star(fragment<n> nested) noexcept {
+    nested.last.for_each(
+        [&](std::size_t p) { automaton.follow[p] |= nested.first; });
+    nested.nullable = true;
+    return nested;
+  }
+};
+
+/**
+ * Adds the positions of an AST to a builder
+ */
+template <typename ast> struct build {
+  template <std::size_t n>
+  constexpr static fragment<n> apply(builder<n> &b) noexcept {
+    return b.atom(char_set_of<ast>::value);
+  }
+};
+
+template <typename... nested> struct build<ast::sequence<nested...>> {
+  template <std::size_t n>
+  constexpr static fragment<n> apply(builder<n> &b) noexcept {
+    fragment<n> result{};
+    ((result = b.concat(result, build<nested>::apply(b))), ...);
+    return result;
+  }
+};
+
+template <> struct build<ast::left_anchor> {
+  template <std::size_t n>
+  constexpr static fragment<n> apply(builder<n> &b) noexcept {
+    b.automaton.left_anchored = true;
+    return {};
+  }
+};
+
+template <> struct build<ast::right_anchor> {
+  template <std::size_t n>
+  constexpr static fragment<n> apply(builder<n> &b) noexcept {
+    b.automaton.right_anchored = true;
+    return {};
+  }
+};
+
+/**
+ * Note: An empty fragment which does not accept the empty string accepts
+ *       nothing, and so makes every sequence containing it accept nothing.
+ */
+template <> struct build<ast::never> {
+  template <std::size_t n>
+  constexpr static fragment<n> apply(builder<n> &) noexcept {
+    fragment<n> result{};
+    result.nullable = false;
+    return result;
+  }
+};
+
+template <typename nested> struct build<ast::zero_or_more<nested>> {
+  template <std::size_t n>
+  constexpr static fragment<n> apply(builder<n> &b) noexcept {
+    return b.star(build<nested>::apply(b));
+  }
+};
+
+template <std::size_t count, typename nested>
+struct build<ast::exactly<count, nested>> {
+  template <std::size_t n>
+  constexpr static fragment<n> apply(builder<n> &b) noexcept {
+    fragment<n> result{};
+    for (std::size_t i = 0; i < count; ++i) {
+      result = b.concat(result, build<nested>::apply(b));
+    }
+    return result;
+  }
+};
+
+template <std::size_t count, typename nested>
+struct build<ast::at_least<count, nested>> {
+  template <std::size_t n>
+  constexpr static fragment<n> apply(builder<n> &b) noexcept {
+    fragment<n> result = build<ast::exactly<count, nested>>::apply(b);
+    return b.concat(result, b.star(build<nested>::apply(b)));
+  }
+};
+
+/**
+ * Note: Up to `count` copies of the same expression accept the same strings
+ *       whether each copy is optional or each copy is nested in the previous,
+ *       so the copies are simply made optional.
+ */
+template <std::size_t count, typename nested>
+struct build<ast::at_most<count, nested>> {
+  template <std::size_t n>
+  constexpr static fragment<n> apply(builder<n> &b) noexcept {
+    fragment<n> result{};
+    for (std::size_t i = 0; i < count; ++i) {
+      fragment<n> copy = build<nested>::apply(b);
+      copy.nullable = true;
+      result = b.concat(result, copy);
+    }
+    return result;
+  }
+};
+
+template <typename nested, typename until>
+struct build<ast::until<nested, until>> {
+  template <std::size_t n>
+  constexpr static fragment<n> apply(builder<n> &b) noexcept {
+    fragment<n> result = b.star(build<nested>::apply(b));
+    return b.concat(result, build<until>::apply(b));
+  }
+};
+
+/**
+ * A UTF-8 class is the alternation of its byte sequences, each of which is a
+ * concatenation of byte ranges
+ */
+template <typename... ranges> struct build<ast::utf8<ranges...>> {
+  template <std::size_t n>
+  constexpr static fragment<n> apply(builder<n> &b) noexcept {
+    const utf8::byte_sequences &sequences =
+        utf8_sequences_of<ast::utf8<ranges...>>::value;
+    fragment<n> result{};
+    result.nullable = false;
+    for (std::size_t i = 0; i < sequences.size; ++i) {
+      const utf8::byte_sequence &sequence = sequences.values[i];
+      fragment<n> alternative{};
+      for (std::size_t j = 0; j < sequence.length; ++j) {
+        char_set symbols{};
+        symbols.insert(static_cast<char>(sequence.lower[j]),
+                       static_cast<char>(sequence.upper[j]));
+        alternative = b.concat(alternative, b.atom(symbols));
+      }
+      result = b.alternate(result, alternative);
+    }
+    return result;
+  }
+};
+
+template <std::size_t n>
+constexpr void index_symbols(glushkov<n> &automaton) noexcept {
+  for (std::size_t p = 1; p < n; ++p) {
+    for (unsigned c = 0; c < 256; ++c) {
+      if (automaton.symbols[p].contains(static_cast<char>(c))) {
+        automaton.by_symbol[c].set(p);
+      }
+    }
+  }
+}
+
+/**
+ * Adds the positions of an AST to a shared automaton as pattern `id`
+ */
+template <typename ast, std::size_t n>
+constexpr void add_pattern(builder<n> &b, std::uint16_t id) noexcept {
+  const std::size_t from = b.next;
+  const fragment<n> whole = build<ast>::apply(b);
+  for (std::size_t p = from; p < b.next; ++p) {
+    b.automaton.token[p] = id;
+  }
+  b.automaton.follow[0] |= whole.first;
+  b.automaton.last |= whole.last;
+}
+
+} // anonymous namespace
+
+/**
+ * Builds the Glushkov automaton of an AST at compile-time
+ */
+template <typename ast> struct glushkov_result {
+  constexpr static const std::size_t size = position_count<ast>::value + 1;
+
+  constexpr static glushkov<size> make() noexcept {
+    builder<size> b{};
+    const fragment<size> whole = build<ast>::apply(b);
+    glushkov<size> &automaton = b.automaton;
+    automaton.follow[0] = whole.first;
+    automaton.last = whole.last;
+    if (whole.nullable) {
+      automaton.last.set(0);
+    }
+    index_symbols(automaton);
+    return automaton;
+  }
+
+  constexpr static const glushkov<size> value = make();
+};
+
+/**
+ * Builds a single Glushkov automaton accepting any of several ASTs at
+ * compile-time, where the positions of the i-th AST have token i
+ *
+ * Note: The empty string is never accepted, even if one of the ASTs accepts it.
+ */
+template <typename... ast> struct glushkov_union {
+  static_assert(sizeof...(ast) < 0xFFFF, "too many patterns in one automaton");
+
+  constexpr static const std::size_t size =
+      (std::size_t{1} + ... + position_count<ast>::value);
+
+  constexpr static glushkov<size> make() noexcept {
+    builder<size> b{};
+    std::uint16_t id = 0;
+    (add_pattern<ast>(b, id++), ...);
+    index_symbols(b.automaton);
+    return b.automaton;
+  }
+
+  constexpr static const glushkov<size> value = make();
+};
+
+} // namespace scry
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "definitions.hpp"
+#include "glushkov.hpp"
+#include "optimise.hpp"
+#include "parser.hpp"
+#include "util.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+namespace scry {
+
+/**
+ * Determinises the Glushkov automaton `source::value` on demand. Each DFA
+ * state is a set of positions and owns a cache-line-aligned row of 256
+ * transitions, which are computed the first time they are taken. At most
+ * `capacity` states exist at once; when a new state is needed and the cache is
+ * full, every state is discarded and determinisation starts again from the
+ * current set of positions. Memory use is therefore fixed by `capacity`
+ * regardless of how large the fully determinised automaton would be, and each
+ * input symbol costs a single table lookup while the cache holds the working
+ * set of states.
+ *
+ * Note: A state cache is mutable and must not be shared between threads
+ *       without synchronisation. State ids are only valid until the next call
+ *       to `next`, which may flush the cache.
+ */
+template <typename source, std::size_t capacity> class state_cache {
+  static_assert(capacity >= 3 && capacity < 0xFFFF,
+                "state cache capacity must be between 3 and 65534 states");
+
+  using automaton_type = decltype(source::value);
+  using set_type = typename automaton_type::set_type;
+
+  constexpr static const automaton_type &automaton = source::value;
+
+  /**
+   * Number of slots in the open-addressed index from position sets to states
+   */
+  constexpr static std::size_t slot_count() noexcept {
+    std::size_t result = 1;
+    while (result < 2 * capacity) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+public:
+  using state_type = std::uint16_t;
+
+  /**
+   * State ids which are reserved after every flush
+   */
+  constexpr static const state_type start = 0;
+  constexpr static const state_type dead = 1;
+
+  /**
+   * Token of a state which does not accept
+   */
+  constexpr static const std::uint16_t none = 0xFFFF;
+
+  state_cache() noexcept { flush(); }
+
+  SCRY_INLINE state_type next(state_type state, unsigned char c) noexcept {
+    const state_type next = rows[state].next[c];
+    return next != 0 ? static_cast<state_type>(next - 1)
+                     : transition(state, c);
+  }
+
+  /**
+   * Lowest token of the accepting positions of a state, or `none`
+   */
+  SCRY_INLINE std::uint16_t token(state_type state) const noexcept {
+    return tokens[state];
+  }
+
+  /**
+   * Number of states currently in the cache
+   */
+  std::size_t states() const noexcept { return size; }
+
+  /**
+   * Number of times the cache has been flushed because it was full
+   */
+  std::uint64_t flushes() const noexcept { return flush_count; }
+
+private:
+  /**
+   * Transitions of a state, stored as `id + 1` so that 0 marks a transition
+   * which has not been computed yet
+   */
+  struct alignas(64) row {
+    state_type next[256];
+  };
+
+  row rows[capacity]{};
+  set_type sets[capacity];
+  std::uint16_t tokens[capacity];
+  state_type slots[slot_count()];
+  std::size_t size{0};
+  std::uint64_t flush_count{0};
+
+  static std::size_t hash(const set_type &positions) noexcept {
+    std::uint64_t result = 0xcbf29ce484222325;
+    for (std::uint64_t word : positions.words) {
+      result = (result ^ word) * 0x100000001b3;
+      result ^= result >> 29;
+    }
+    return static_cast<std::size_t>(result);
+  }
+
+  /**
+   * Discards every state, keeping only the start and dead states
+   */
+  void flush() noexcept {
+    std::memset(rows, 0, sizeof(row) * size);
+    std::memset(slots, 0, sizeof(slots));
+    size = 0;
+
+    set_type initial{};
+    initial.set(0);
+    insert(initial);
+    insert(set_type{});
+  }
+
+  state_type insert(const set_type &positions) noexcept {
+    std::size_t slot = hash(positions) & (slot_count() - 1);
+    while (slots[slot] != 0) {
+      slot = (slot + 1) & (slot_count() - 1);
+    }
+    const state_type id = static_cast<state_type>(size++);
+    slots[slot] = static_cast<state_type>(id + 1);
+    sets[id] = positions;
+    tokens[id] = none;
+    (positions & automaton.last).for_each([&](std::size_t p) {
+      if (automaton.token[p] < tokens[id]) {
+        tokens[id] = automaton.token[p];
+      }
+    });
+    return id;
+  }
+
+  /**
+   * Finds the state for a set of positions, or `capacity` if there is none
+   */
+  std::size_t find(const set_type &positions) const noexcept {
+    std::size_t slot = hash(positions) & (slot_count() - 1);
+    for (; slots[slot] != 0; slot = (slot + 1) & (slot_count() - 1)) {
+      const std::size_t id = slots[slot] - 1;
+      if (sets[id] == positions) {
+        return id;
+      }
+    }
+    return capacity;
+  }
+
+  /**
+   * Computes, caches and returns the transition of a state on `c`
+   */
+  state_type transition(state_type state, unsigned char c) noexcept {
+    set_type target{};
+    sets[state].for_each(
+        [&](std::size_t p) { target |= automaton.follow[p]; });
+    target = target & automaton.by_symbol[c];
+
+    const std::size_t found = find(target);
+    if (found != capacity) {
+      rows[state].next[c] = static_cast<state_type>(found + 1);
+      return static_cast<state_type>(found);
+    }
+    if (size == capacity) {
+      ++flush_count;
+      flush();
+      return insert(target);
+    }
+    const state_type id = insert(target);
+    rows[state].next[c] = static_cast<state_type>(id + 1);
+    return id;
+  }
+};
+
+/**
+ * Matches a regex with a lazily determinised automaton (see `state_cache`),
+ * which never backtracks and uses memory fixed by `capacity`. The cache is
+ * allocated once, when the automaton is constructed, so the automaton itself
+ * is small enough for the stack and matching never allocates
+ */
+template <typename regex, std::size_t capacity = 256> class lazy_dfa {
+  using tree = typename parse_result<
+      regex, std::make_index_sequence<regex::string::size>>::type;
+  using opt_tree = typename optimise_result<tree>::type;
+  using cache_type = state_cache<glushkov_result<opt_tree>, capacity>;
+
+public:
+  lazy_dfa() : cache{std::make_unique<cache_type>()} {}
+
+  template <typename it_type> bool match(it_type begin, it_type end) noexcept {
+    static_assert(has_byte_units<it_type>::value,
+                  "lazy DFAs can only match bytes");
+    typename cache_type::state_type state = cache_type::start;
+    for (; begin != end; ++begin) {
+      state = cache->next(state, static_cast<unsigned char>(*begin));
+      if (state == cache_type::dead) {
+        return false;
+      }
+    }
+    return cache->token(state) != cache_type::none;
+  }
+
+  /**
+   * Number of states currently in the cache
+   */
+  std::size_t states() const noexcept { return cache->states(); }
+
+  /**
+   * Number of times the cache has been flushed because it was full
+   */
+  std::uint64_t flushes() const noexcept { return cache->flushes(); }
+
+private:
+  std::unique_ptr<cache_type> cache;
+};
+
+} // namespace scry
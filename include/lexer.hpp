@@ -0,0 +1,169 @@
+#pragma once
+
+#include "glushkov.hpp"
+#include "lazy_dfa.hpp"
+#include "optimise.hpp"
+#include "parser.hpp"
+#include "util.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace scry {
+
+/**
+ * Token found by a lexer: the index of the regex which matched [begin, end),
+ * or the lexer's `nomatch` if no regex matched at `begin`
+ */
+template <typename it_type> struct lexeme {
+  std::size_t id;
+  it_type begin;
+  it_type end;
+};
+
+namespace {
+
+template <typename regex> struct optimised_ast {
+  using type = typename optimise_result<typename parse_result<
+      regex, std::make_index_sequence<regex::string::size>>::type>::type;
+};
+
+} // anonymous namespace
+
+/**
+ * Splits input into tokens, where each token is the longest prefix matched by
+ * any of `regex...`. When several regexes match the longest prefix, the token
+ * has the id of the first of them.
+ *
+ * All regexes are merged into a single automaton at compile-time, which is
+ * determinised lazily into a fixed-size cache of `capacity` states (see
+ * `state_cache`), so lexing examines each symbol once for all regexes
+ * together. The cache is allocated once, when the lexer is constructed, so a
+ * lexer is small enough for the stack and lexing never allocates. Regexes
+ * which match the empty string never produce empty tokens, and a symbol which
+ * starts no token is returned as a single-symbol `nomatch` token.
+ *
+ * Note: A lexer is mutable and must not be shared between threads without
+ *       synchronisation.
+ */
+template <typename... regex> class lexer {
+  static_assert(sizeof...(regex) > 0, "lexer requires at least one regex");
+
+  constexpr static const std::size_t capacity = 256;
+
+  using source = glushkov_union<typename optimised_ast<regex>::type...>;
+  using cache_type = state_cache<source, capacity>;
+
+  static_assert(!source::value.left_anchored && !source::value.right_anchored,
+                "lexer regexes cannot be anchored");
+
+public:
+  /**
+   * Id of tokens which no regex matched
+   */
+  constexpr static const std::size_t nomatch = sizeof...(regex);
+
+  lexer() : cache{std::make_unique<cache_type>()} {}
+
+  /**
+   * Lexes the token starting at `begin`, which must not be `end`
+   */
+  template <typename it_type>
+  lexeme<it_type> next(it_type begin, it_type end) noexcept {
+    static_assert(has_byte_units<it_type>::value, "lexers can only lex bytes");
+    lexeme<it_type> result{nomatch, begin, std::next(begin)};
+    typename cache_type::state_type state = cache_type::start;
+    for (it_type it = begin; it != end;) {
+      state = cache->next(state, static_cast<unsigned char>(*it));
+      if (state == cache_type::dead) {
+        break;
+      }
+      ++it;
+      if (cache->token(state) != cache_type::none) {
+        result.id = cache->token(state);
+        result.end = it;
+      }
+    }
+    return result;
+  }
+
+  /**
+   * Iterates over the tokens of a range, lexing each on demand
+   */
+  template <typename it_type> class iterator {
+
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = lexeme<it_type>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type *;
+    using reference = const value_type &;
+
+    iterator() noexcept = default;
+
+    iterator(lexer &source, it_type begin, it_type end) noexcept
+        : owner{&source}, current{nomatch, begin, begin}, last{end} {
+      lex();
+    }
+
+    reference operator*() const noexcept { return current; }
+    pointer operator->() const noexcept { return &current; }
+
+    iterator &operator++() noexcept {
+      current.begin = current.end;
+      lex();
+      return *this;
+    }
+
+    iterator operator++(int) noexcept {
+      iterator result = *this;
+      ++*this;
+      return result;
+    }
+
+    friend bool operator==(const iterator &left,
+                           const iterator &right) noexcept {
+      return left.current.begin == right.current.begin;
+    }
+
+    friend bool operator!=(const iterator &left,
+                           const iterator &right) noexcept {
+      return !(left == right);
+    }
+
+  private:
+    lexer *owner{nullptr};
+    value_type current{};
+    it_type last{};
+
+    void lex() noexcept {
+      if (current.begin != last) {
+        current = owner->next(current.begin, last);
+      }
+    }
+  };
+
+  template <typename it_type> struct range {
+    iterator<it_type> first;
+    iterator<it_type> last;
+
+    iterator<it_type> begin() const noexcept { return first; }
+    iterator<it_type> end() const noexcept { return last; }
+  };
+
+  /**
+   * Lazily lexes every token of [begin, end)
+   */
+  template <typename it_type>
+  range<it_type> tokens(it_type begin, it_type end) noexcept {
+    return {iterator<it_type>{*this, begin, end},
+            iterator<it_type>{*this, end, end}};
+  }
+
+private:
+  std::unique_ptr<cache_type> cache;
+};
+
+} // namespace scry
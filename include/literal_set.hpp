@@ -0,0 +1,305 @@
+#pragma once
+
+#include "ct_string.hpp"
+#include "definitions.hpp"
+#include "search.hpp"
+#include "util.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+namespace scry {
+
+/**
+ * Range of the input matched by one of the words of a literal set, and the id
+ * of that word
+ */
+template <typename it_type> struct literal_match : sub_match<it_type> {
+  std::size_t id{0};
+};
+
+/**
+ * Matches and searches for a fixed set of words, where the id of each word is
+ * its index in `words...` (e.g. HTTP methods, log levels or field names).
+ *
+ * Whole inputs are matched by a trie of the words unrolled at compile-time
+ * into nested comparisons of one symbol each, so the input is read once and
+ * no word is compared against it in full. Inputs are searched by an
+ * Aho-Corasick automaton built at compile-time, with a transition for every
+ * state and byte, so each symbol of the input costs one table lookup however
+ * many words are in the set.
+ *
+ * Note: When several words are equal, the first has the id of them all.
+ */
+template <const char *... words> class literal_set {
+  static_assert(sizeof...(words) > 0, "literal_set requires at least one word");
+
+public:
+  /**
+   * Number of words, and so the id returned when no word matches
+   */
+  constexpr static const std::size_t size = sizeof...(words);
+
+private:
+  constexpr static const char *const spellings[] = {words...};
+  constexpr static const std::size_t lengths[] = {ct_string<words>::size...};
+
+  /**
+   * Node of the trie at depth `depth`, whose words `ids` all start with the
+   * same `depth` symbols
+   */
+  template <std::size_t depth, typename ids> struct trie;
+
+  template <std::size_t depth, std::size_t... ids>
+  struct trie<depth, std::index_sequence<ids...>> {
+
+    /**
+     * Distinct symbols at `depth` of the words longer than `depth`
+     */
+    struct symbol_set {
+      char values[sizeof...(ids)]{};
+      std::size_t size{0};
+    };
+
+    constexpr static symbol_set make_symbols() noexcept {
+      symbol_set result{};
+      for (std::size_t id : {ids...}) {
+        if (lengths[id] <= depth) {
+          continue;
+        }
+        const char c = spellings[id][depth];
+        bool seen = false;
+        for (std::size_t i = 0; i < result.size; ++i) {
+          seen = seen || result.values[i] == c;
+        }
+        if (!seen) {
+          result.values[result.size++] = c;
+        }
+      }
+      return result;
+    }
+
+    constexpr static const symbol_set symbols = make_symbols();
+
+    /**
+     * Word of `ids` which ends at `depth`, if any
+     */
+    constexpr static std::size_t make_terminal() noexcept {
+      for (std::size_t id : {ids...}) {
+        if (lengths[id] == depth) {
+          return id;
+        }
+      }
+      return size;
+    }
+
+    constexpr static const std::size_t terminal = make_terminal();
+
+    template <char c> constexpr static bool continues(std::size_t id) noexcept {
+      return lengths[id] > depth && spellings[id][depth] == c;
+    }
+
+    /**
+     * The `k`th of the words `ids` continuing with `c`
+     */
+    template <char c>
+    constexpr static std::size_t child_id(std::size_t k) noexcept {
+      for (std::size_t id : {ids...}) {
+        if (continues<c>(id) && k-- == 0) {
+          return id;
+        }
+      }
+      return size;
+    }
+
+    template <char c, std::size_t... k>
+    constexpr static auto make_child(std::index_sequence<k...>) noexcept
+        -> trie<depth + 1, std::index_sequence<child_id<c>(k)...>>;
+
+    template <char c>
+    using child = decltype(make_child<c>(std::make_index_sequence<(
+                                             std::size_t{0} + ... +
+                                             continues<c>(ids))>{}));
+
+    template <typename it_type, std::size_t... k>
+    SCRY_INLINE constexpr static std::size_t
+    branch(it_type begin, it_type end, std::index_sequence<k...>) noexcept {
+      const auto c = unit_value(*begin);
+      std::size_t result = size;
+      static_cast<void>(
+          ((c == unit_value(symbols.values[k]) &&
+            (result = child<symbols.values[k]>::find(std::next(begin), end),
+             true)) ||
+           ...));
+      return result;
+    }
+
+    template <typename it_type>
+    SCRY_INLINE constexpr static std::size_t find(it_type begin,
+                                                  it_type end) noexcept {
+      if (begin == end) {
+        return terminal;
+      }
+      if constexpr (symbols.size == 0) {
+        return size;
+      } else {
+        return branch(begin, end, std::make_index_sequence<symbols.size>{});
+      }
+    }
+  };
+
+  using root = trie<0, std::make_index_sequence<size>>;
+
+  constexpr static const std::size_t states =
+      (std::size_t{1} + ... + ct_string<words>::size);
+
+  static_assert(states <= 65536,
+                "literal_set supports words of at most 65535 symbols in all");
+
+  /**
+   * Aho-Corasick automaton of the words. State 0 is the empty prefix, and
+   * every other state a prefix of at least one word.
+   */
+  struct automaton {
+    std::uint16_t next[states][256]{};
+    std::size_t depth[states]{};
+    // Id and length of the longest word which is a suffix of each state
+    std::size_t accepts[states]{};
+    std::size_t longest[states]{};
+  };
+
+  constexpr static automaton make() noexcept {
+    automaton result{};
+    for (std::size_t s = 0; s < states; ++s) {
+      result.accepts[s] = size;
+    }
+    // Build the trie of the words, where a transition to 0 is absent
+    std::size_t count = 1;
+    for (std::size_t id = 0; id < size; ++id) {
+      std::size_t s = 0;
+      for (std::size_t i = 0; i < lengths[id]; ++i) {
+        const unsigned char c = unit_value(spellings[id][i]);
+        if (result.next[s][c] == 0) {
+          result.depth[count] = result.depth[s] + 1;
+          result.next[s][c] = static_cast<std::uint16_t>(count++);
+        }
+        s = result.next[s][c];
+      }
+      if (result.accepts[s] == size) {
+        result.accepts[s] = id;
+        result.longest[s] = lengths[id];
+      }
+    }
+    // Visit states breadth-first, so that the failure state of each state is
+    // complete before it is used, replacing absent transitions with those of
+    // the failure state
+    std::size_t fail[states]{};
+    std::size_t queue[states]{};
+    std::size_t head = 0;
+    std::size_t tail = 0;
+    queue[tail++] = 0;
+    while (head < tail) {
+      const std::size_t s = queue[head++];
+      for (std::size_t c = 0; c < 256; ++c) {
+        const std::size_t t = result.next[s][c];
+        const std::size_t fallback = s == 0 ? 0 : result.next[fail[s]][c];
+        if (t == 0) {
+          result.next[s][c] = static_cast<std::uint16_t>(fallback);
+          continue;
+        }
+        fail[t] = fallback;
+        if (result.accepts[t] == size) {
+          result.accepts[t] = result.accepts[fallback];
+          result.longest[t] = result.longest[fallback];
+        }
+        queue[tail++] = t;
+      }
+    }
+    return result;
+  }
+
+  constexpr static const automaton table = make();
+
+  /**
+   * State after `s` on the symbol `c`, where symbols which are not bytes are
+   * in no word
+   */
+  template <typename symbol_type>
+  SCRY_INLINE constexpr static std::size_t
+  transition(std::size_t s, symbol_type c) noexcept {
+    if constexpr (sizeof(symbol_type) == 1) {
+      return table.next[s][c];
+    } else {
+      return c < 256 ? table.next[s][c] : 0;
+    }
+  }
+
+public:
+  /**
+   * Id of the word equal to [begin, end), or `size` if there is none
+   */
+  template <typename it_type>
+  constexpr static std::size_t find(it_type begin, it_type end) noexcept {
+    return root::find(begin, end);
+  }
+
+  constexpr static std::size_t find(std::string_view str) noexcept {
+    return find(str.data(), str.data() + str.size());
+  }
+
+  /**
+   * Determines whether [begin, end) is one of the words
+   */
+  template <typename it_type>
+  constexpr static bool match(it_type begin, it_type end) noexcept {
+    return find(begin, end) != size;
+  }
+
+  constexpr static bool match(std::string_view str) noexcept {
+    return match(str.data(), str.data() + str.size());
+  }
+
+  /**
+   * Finds the leftmost occurrence of any of the words in [begin, end), and
+   * the longest of the words occurring there. The input is scanned once,
+   * until no later occurrence can start at or before the one found.
+   */
+  template <typename it_type>
+  constexpr static literal_match<it_type> search(it_type begin,
+                                                 it_type end) noexcept {
+    std::size_t id = table.accepts[0];
+    std::size_t start = 0;
+    std::size_t length = 0;
+    std::size_t s = 0;
+    std::size_t i = 0;
+    for (it_type it = begin; it != end; ++it, ++i) {
+      s = transition(s, unit_value(*it));
+      if (id != size && i + 1 - table.depth[s] > start) {
+        break;
+      }
+      if (table.accepts[s] != size) {
+        const std::size_t found = i + 1 - table.longest[s];
+        if (id == size || found <= start) {
+          id = table.accepts[s];
+          start = found;
+          length = table.longest[s];
+        }
+      }
+    }
+    if (id == size) {
+      return {{end, end, false}, size};
+    }
+    const it_type first = std::next(begin, start);
+    return {{first, std::next(first, length), true}, id};
+  }
+
+  constexpr static literal_match<const char *>
+  search(std::string_view str) noexcept {
+    return search(str.data(), str.data() + str.size());
+  }
+};
+
+} // namespace scry
@@ -5,9 +5,12 @@
 #include "optimise.hpp"
 #include "parser.hpp"
 #include "regex.hpp"
+#include "reverse.hpp"
 
 #include <cassert>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <utility>
 
 namespace scry {
@@ -15,35 +18,101 @@ namespace scry {
 namespace {
 
 /**
- * Helper to get begin iterator of const char pointer
+ * Helper to get begin iterator of a null-terminated string
  */
-const char *begin(const char *str) { return str; }
+template <typename unit> constexpr const unit *begin(const unit *str) noexcept {
+  return str;
+}
 
 /**
- * Helper to get the end iterator of a const char pointer
+ * Helper to get the end iterator of a null-terminated string
  */
-const char *end(const char *str) {
-  while (*str != '\0')
+template <typename unit> constexpr const unit *end(const unit *str) noexcept {
+  while (*str != unit{})
     ++str;
   return str;
 }
 
-} // namespace
+template <bool reversed, typename regex, typename opt_tree>
+struct select_program {
+  using type = typename codegen_result<opt_tree>::type;
+};
 
-template <typename regex, typename it_type>
-bool regex_match(it_type begin, it_type end) noexcept {
+template <typename regex, typename opt_tree>
+struct select_program<true, regex, opt_tree> {
+  using type = typename reverse_result<regex>::code;
+};
+
+/**
+ * The op program which matches whole inputs of type `it_type` against
+ * `regex`, which is compiled in reverse when the regex is cheaper to match
+ * from the end of the input (see `prefers_reverse`) and the iterators can be
+ * reversed
+ */
+template <typename regex, typename it_type> struct match_program {
   using tree = typename parse_result<
       regex, std::make_index_sequence<regex::string::size>>::type;
   using opt_tree = typename optimise_result<tree>::type;
-  using code = typename codegen_result<opt_tree>::type;
-  return code::execute(begin, end) == end;
+  constexpr static const bool reversed = prefers_reverse<opt_tree>::value &&
+                                         !is_utf8_regex<regex>::value &&
+                                         is_bidirectional<it_type>::value;
+  using code = typename select_program<reversed, regex, opt_tree>::type;
+};
+
+/**
+ * Determines whether the whole of [begin, end) matches `regex`, always inlined
+ * so that callers matching many inputs in a loop make no calls per input
+ */
+template <typename regex, typename it_type>
+SCRY_INLINE constexpr bool match_whole(it_type begin, it_type end) noexcept {
+  using program = match_program<regex, it_type>;
+  if constexpr (program::reversed) {
+    using reverse_it = std::reverse_iterator<it_type>;
+    return op::dispatch<typename program::code>(reverse_it{end},
+                                                reverse_it{begin}) ==
+           reverse_it{begin};
+  } else {
+    return op::dispatch<typename program::code>(begin, end) == end;
+  }
+}
+
+} // namespace
+
+/**
+ * Determines whether the whole of [begin, end) matches `regex`
+ *
+ * Note: Matching is a constant expression whenever the iterators are, so
+ *       constant inputs can be matched in `static_assert`s and `constexpr`
+ *       initialisers. Profiling (see profile.hpp) only records executions
+ *       at runtime.
+ *
+ * Note: The input may have any code-unit type, e.g. `char16_t` for UTF-16 or
+ *       `std::uint8_t` for binary data, and each unit is compared with the
+ *       pattern's symbols by value (see `unit_value`). Patterns are strings of
+ *       `char`, so they can only name units up to 0xFF, and wider units are
+ *       matched only by "." and non-matching lists.
+ *
+ * Note: Regexes which are cheaper to match from the end of the input (see
+ *       `prefers_reverse`) are compiled in reverse and executed on reverse
+ *       iterators, when the iterators are bidirectional.
+ */
+template <typename regex, typename it_type>
+constexpr bool regex_match(it_type begin, it_type end) noexcept {
+  return match_whole<regex>(begin, end);
 }
 
-template <typename regex> bool regex_match(const char *str) noexcept {
+template <typename regex, typename unit>
+constexpr bool regex_match(const unit *str) noexcept {
   return regex_match<regex>(begin(str), end(str));
 }
 
-template <typename regex> bool regex_match(std::string str) noexcept {
+template <typename regex, typename unit>
+constexpr bool regex_match(std::basic_string_view<unit> str) noexcept {
+  return regex_match<regex>(str.data(), str.data() + str.size());
+}
+
+template <typename regex, typename unit>
+bool regex_match(const std::basic_string<unit> &str) noexcept {
   return regex_match<regex>(str.begin(), str.end());
 }
 
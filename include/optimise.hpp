@@ -11,12 +11,342 @@ namespace ast {
 
 template <typename nested, typename next> struct until;
 
+/**
+ * Accepts nothing, replacing sequences which can never be matched
+ */
+struct never;
+
 } // namespace ast
 
 namespace {
 
+/**
+ * Upper bound of a repetition without one
+ */
+constexpr static const std::size_t unbounded = static_cast<std::size_t>(-1);
+
+constexpr std::size_t add_bounds(std::size_t a, std::size_t b) noexcept {
+  return a == unbounded || b == unbounded ? unbounded : a + b;
+}
+
+constexpr std::size_t multiply_bounds(std::size_t a, std::size_t b) noexcept {
+  if (a == 0 || b == 0) {
+    return 0;
+  }
+  return a == unbounded || b == unbounded ? unbounded : a * b;
+}
+
+/**
+ * Determines whether between `a` and `b` repetitions of between `c` and `d`
+ * repetitions of an AST accept every count of the AST between `a * c` and
+ * `b * d`, and so may be replaced by a single repetition. This is the case
+ * when the counts accepted by `k` and `k + 1` outer repetitions overlap or
+ * meet for every `k`, which is hardest for the fewest outer repetitions.
+ */
+constexpr bool repetitions_collapse(std::size_t a, std::size_t b,
+                                    std::size_t c, std::size_t d) noexcept {
+  if (a == b) {
+    return true;
+  }
+  if (a == 0) {
+    return c <= 1;
+  }
+  return d == unbounded || (a + 1) * c <= a * d + 1;
+}
+
+/**
+ * Between `lower` and `upper` repetitions of `nested`, the form every
+ * quantifier takes while a sequence is normalised
+ */
+template <std::size_t lower, std::size_t upper, typename nested>
+struct repetition;
+
+/**
+ * Rewrites an AST into a normal form where nested quantifiers are collapsed
+ * into one where possible, adjacent repetitions of the same AST are merged,
+ * and sequences which can never match are replaced by `ast::never`.
+ * Quantifiers become `repetition`s, which are rewritten back into
+ * quantifiers by `emit`.
+ */
+template <typename ast> struct normalise { using type = ast; };
+
+/**
+ * Repeats the normalised AST `nested` between `a` and `b` times
+ */
+template <std::size_t a, std::size_t b, typename nested> struct quantify {
+  using type = typename std::conditional<b == 0, ast::sequence<>,
+                                         repetition<a, b, nested>>::type;
+};
+
+template <std::size_t a, std::size_t b>
+struct quantify<a, b, ast::sequence<>> {
+  using type = ast::sequence<>;
+};
+
+template <std::size_t a, std::size_t b, typename nested>
+struct quantify<a, b, ast::sequence<nested>> : quantify<a, b, nested> {};
+
+template <typename ast> struct emit;
+
+template <std::size_t a, std::size_t b, typename... nested>
+struct quantify<a, b, ast::sequence<nested...>> {
+  using type = typename std::conditional<
+      b == 0, ast::sequence<>,
+      repetition<a, b, typename emit<ast::sequence<nested...>>::single>>::type;
+};
+
+template <std::size_t a, std::size_t b, std::size_t c, std::size_t d,
+          typename nested>
+struct quantify<a, b, repetition<c, d, nested>> {
+  using type = typename std::conditional<
+      b == 0, ast::sequence<>,
+      typename std::conditional<
+          repetitions_collapse(a, b, c, d),
+          repetition<multiply_bounds(a, c), multiply_bounds(b, d), nested>,
+          repetition<a, b,
+                     typename emit<repetition<c, d, nested>>::single>>::type>::
+      type;
+};
+
+template <typename nested> struct normalise<ast::zero_or_more<nested>> {
+  using type =
+      typename quantify<0, unbounded, typename normalise<nested>::type>::type;
+};
+
+template <std::size_t n, typename nested>
+struct normalise<ast::exactly<n, nested>> {
+  using type = typename quantify<n, n, typename normalise<nested>::type>::type;
+};
+
+template <std::size_t n, typename nested>
+struct normalise<ast::at_least<n, nested>> {
+  using type =
+      typename quantify<n, unbounded, typename normalise<nested>::type>::type;
+};
+
+template <std::size_t n, typename nested>
+struct normalise<ast::at_most<n, nested>> {
+  using type = typename quantify<0, n, typename normalise<nested>::type>::type;
+};
+
+/**
+ * Joins two adjacent normalised ASTs into a list of one or two ASTs.
+ * Repetitions of the same AST are merged, as `a` to `b` repetitions followed
+ * by `c` to `d` repetitions accept every count from `a + c` to `b + d`. After
+ * a right anchor, ASTs which may accept nothing are dropped and any other AST
+ * can never match.
+ */
+template <typename left, typename right> struct join {
+  using type = list<left, right>;
+};
+
+template <std::size_t a, std::size_t b, std::size_t c, std::size_t d,
+          typename nested>
+struct join<repetition<a, b, nested>, repetition<c, d, nested>> {
+  using type = list<repetition<a + c, add_bounds(b, d), nested>>;
+};
+
+template <std::size_t a, std::size_t b, typename nested>
+struct join<repetition<a, b, nested>, nested> {
+  using type = list<repetition<a + 1, add_bounds(b, 1), nested>>;
+};
+
+template <std::size_t a, std::size_t b, typename nested>
+struct join<nested, repetition<a, b, nested>> {
+  using type = list<repetition<a + 1, add_bounds(b, 1), nested>>;
+};
+
+template <typename right> struct join<ast::right_anchor, right> {
+  using type = list<ast::never>;
+};
+
+template <std::size_t b, typename nested>
+struct join<ast::right_anchor, repetition<0, b, nested>> {
+  using type = list<ast::right_anchor>;
+};
+
+template <> struct join<ast::right_anchor, ast::right_anchor> {
+  using type = list<ast::right_anchor>;
+};
+
+template <> struct join<ast::right_anchor, ast::left_anchor> {
+  using type = list<ast::right_anchor, ast::left_anchor>;
+};
+
+template <typename right> struct join<ast::never, right> {
+  using type = list<ast::never>;
+};
+
+/**
+ * Normalises the ASTs `todo` of a sequence, given the ASTs `done` already
+ * normalised. Nested sequences are flattened, so that their elements may be
+ * joined with those around them.
+ */
+template <typename done, typename todo> struct normalise_sequence;
+
+template <typename... done> struct normalise_sequence<list<done...>, list<>> {
+  using type = ast::sequence<done...>;
+};
+
+template <typename done, typename head, typename todo> struct normalise_step;
+
+template <typename done, typename head, typename... todo>
+struct normalise_sequence<done, list<head, todo...>> {
+  using type = typename normalise_step<done, typename normalise<head>::type,
+                                       list<todo...>>::type;
+};
+
+/**
+ * Specialization of `normalise_sequence` for between `n` and `n + m`
+ * repetitions, which are parsed as `ast::exactly` followed by `ast::at_most`
+ * and must be quantified as one so that they may collapse with a nested
+ * quantifier
+ */
+template <typename done, std::size_t n, std::size_t m, typename nested,
+          typename... todo>
+struct normalise_sequence<
+    done, list<ast::exactly<n, nested>, ast::at_most<m, nested>, todo...>> {
+  using type = typename normalise_step<
+      done,
+      typename quantify<n, n + m, typename normalise<nested>::type>::type,
+      list<todo...>>::type;
+};
+
+template <typename... nested, typename... todo>
+struct normalise_step<list<>, ast::sequence<nested...>, list<todo...>> {
+  using type =
+      typename normalise_sequence<list<>, list<nested..., todo...>>::type;
+};
+
+template <typename... done, typename... nested, typename... todo>
+struct normalise_step<list<done...>, ast::sequence<nested...>,
+                      list<todo...>> {
+  using type = typename normalise_sequence<list<done...>,
+                                          list<nested..., todo...>>::type;
+};
+
+template <typename head, typename todo>
+struct normalise_step<list<>, head, todo> {
+  using type = typename normalise_sequence<list<head>, todo>::type;
+};
+
+template <typename... done, typename head, typename todo>
+struct normalise_step<list<done...>, head, todo> {
+  using joined =
+      typename join<typename last<list<done...>>::type, head>::type;
+  using type = typename normalise_sequence<
+      typename concat<typename init<list<done...>>::type, joined>::type,
+      todo>::type;
+};
+
+template <typename... nested> struct normalise<ast::sequence<nested...>> {
+  using type = typename normalise_sequence<list<>, list<nested...>>::type;
+};
+
+template <typename asts> struct as_sequence;
+
+template <typename... asts> struct as_sequence<list<asts...>> {
+  using type = ast::sequence<asts...>;
+};
+
+/**
+ * Rewrites a normalised AST back into quantifiers, as a `list` of ASTs and as
+ * a `single` AST. Between `n` and infinitely many repetitions are rewritten
+ * into `ast::at_least`, and between `n` and `m` repetitions into
+ * `ast::exactly` followed by `ast::at_most`, as they are parsed. A sequence
+ * containing `ast::never` is replaced by it.
+ */
+template <typename ast> struct emit {
+  using type = list<ast>;
+  using single = ast;
+};
+
+template <std::size_t lower, std::size_t upper, typename nested>
+struct emit<repetition<lower, upper, nested>> {
+  using required = typename std::conditional<
+      lower == 0, list<>,
+      typename std::conditional<lower == 1, list<nested>,
+                                list<ast::exactly<lower, nested>>>::type>::
+      type;
+  using type = typename std::conditional<
+      upper == unbounded,
+      typename std::conditional<lower == 0, list<ast::zero_or_more<nested>>,
+                                list<ast::at_least<lower, nested>>>::type,
+      typename std::conditional<
+          upper == lower, required,
+          typename append<required, ast::at_most<upper - lower, nested>>::
+              type>::type>::type;
+  using single = typename std::conditional<
+      size_of<type>::value == 1, typename last<type>::type,
+      typename as_sequence<type>::type>::type;
+};
+
+template <typename emitted, typename... nested> struct emit_sequence {
+  using type = typename as_sequence<emitted>::type;
+};
+
+template <typename emitted, typename head, typename... tail>
+struct emit_sequence<emitted, head, tail...> {
+  using type = typename emit_sequence<
+      typename concat<emitted, typename emit<head>::type>::type,
+      tail...>::type;
+};
+
+template <typename... nested> struct emit<ast::sequence<nested...>> {
+  using type = typename std::conditional<
+      (std::is_same<nested, ast::never>::value || ...),
+      ast::sequence<ast::never>,
+      typename emit_sequence<list<>, nested...>::type>::type;
+  using single = type;
+};
+
 template <typename ast> struct optimise { using type = ast; };
 
+/**
+ * Determines whether a single-symbol AST accepts the symbol `c`
+ */
+template <typename ast, char c> struct admits;
+
+template <char c> struct admits<ast::any, c> {
+  constexpr static const bool value = true;
+};
+
+template <char s, char c> struct admits<ast::symbol<s>, c> {
+  constexpr static const bool value = s == c;
+};
+
+template <char lower, char upper, char c>
+struct admits<ast::range<lower, upper>, c> {
+  constexpr static const bool value = unit_value(lower) <= unit_value(c) &&
+                                      unit_value(c) <= unit_value(upper);
+};
+
+template <typename... nested, char c> struct admits<ast::any_of<nested...>, c> {
+  constexpr static const bool value = (admits<nested, c>::value || ...);
+};
+
+template <typename... nested, char c>
+struct admits<ast::none_of<nested...>, c> {
+  constexpr static const bool value = !(admits<nested, c>::value || ...);
+};
+
+/**
+ * Transforms a quantified class followed by a symbol into an `ast::until`
+ * where either the class is "." or the class cannot accept the symbol. In both
+ * cases the quantifier only needs to stop at occurrences of the symbol, which
+ * can be found without stepping through the class symbol by symbol.
+ */
+template <typename nested, char c, typename... tail> struct optimise_until {
+  constexpr static const bool applies =
+      std::is_same<nested, ast::any>::value || !admits<nested, c>::value;
+  using type = typename std::conditional<
+      applies,
+      prepend<typename optimise<ast::sequence<tail...>>::type,
+              ast::until<nested, ast::symbol<c>>>,
+      prepend<typename optimise<ast::sequence<ast::symbol<c>, tail...>>::type,
+              ast::zero_or_more<nested>>>::type::type;
+};
+
 template <typename head, typename... tail>
 struct optimise<ast::sequence<head, tail...>> {
   using type = typename prepend<typename optimise<ast::sequence<tail...>>::type,
@@ -33,6 +363,48 @@ struct optimise<ast::sequence<ast::zero_or_more<head>, head, tail...>> {
       ast::sequence<head, ast::zero_or_more<head>, tail...>>::type;
 };
 
+template <char c, typename... tail>
+struct optimise<
+    ast::sequence<ast::zero_or_more<ast::any>, ast::symbol<c>, tail...>> {
+  using type = typename optimise_until<ast::any, c, tail...>::type;
+};
+
+template <char lower, char upper, char c, typename... tail>
+struct optimise<ast::sequence<ast::zero_or_more<ast::range<lower, upper>>,
+                              ast::symbol<c>, tail...>> {
+  using type =
+      typename optimise_until<ast::range<lower, upper>, c, tail...>::type;
+};
+
+template <typename... nested, char c, typename... tail>
+struct optimise<ast::sequence<ast::zero_or_more<ast::any_of<nested...>>,
+                              ast::symbol<c>, tail...>> {
+  using type =
+      typename optimise_until<ast::any_of<nested...>, c, tail...>::type;
+};
+
+template <typename... nested, char c, typename... tail>
+struct optimise<ast::sequence<ast::zero_or_more<ast::none_of<nested...>>,
+                              ast::symbol<c>, tail...>> {
+  using type =
+      typename optimise_until<ast::none_of<nested...>, c, tail...>::type;
+};
+
+/**
+ * Transforms "A\{n,\}c" into "A\{n\}A*c", so that the unbounded part of the
+ * repetition may be transformed into an `ast::until`
+ */
+template <std::size_t n, typename nested, char c, typename... tail>
+struct optimise<
+    ast::sequence<ast::at_least<n, nested>, ast::symbol<c>, tail...>> {
+  using required =
+      typename std::conditional<n == 1, nested, ast::exactly<n, nested>>::type;
+  using type = typename prepend<
+      typename optimise<ast::sequence<ast::zero_or_more<nested>,
+                                      ast::symbol<c>, tail...>>::type,
+      required>::type;
+};
+
 /**
  * Flattens `ast::sequence`s into a single `ast::sequence`
  */
@@ -44,7 +416,9 @@ struct optimise<ast::sequence<ast::sequence<nested...>, tail...>> {
 } // anonymous namespace
 
 template <typename ast> struct optimise_result {
-  using type = typename optimise<ast>::type;
+  using normal_form =
+      typename emit<typename normalise<ast>::type>::type;
+  using type = typename optimise<normal_form>::type;
 };
 
 } // namespace  scry
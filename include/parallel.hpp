@@ -0,0 +1,300 @@
+#pragma once
+
+#include "match.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Overloads of `regex_match_parallel` taking a standard execution policy are
+ * declared when `SCRY_EXECUTION_POLICY` is defined before including scry, as
+ * the standard library may require linking a threading library (e.g. TBB)
+ * once <execution> is included.
+ */
+#if defined(SCRY_EXECUTION_POLICY)
+#include <execution>
+#include <type_traits>
+#endif
+
+namespace scry {
+
+/**
+ * Fixed set of threads which execute the chunks of a job. The chunks of each
+ * job are divided evenly between the threads, and a thread which runs out of
+ * chunks steals half of the remaining chunks of another thread, so uneven
+ * chunks are balanced without a shared queue. The thread which runs a job
+ * executes chunks alongside the workers until the job is finished.
+ *
+ * Note: Jobs run one at a time, so concurrent calls to `run` wait for each
+ *       other. Chunks must not throw.
+ */
+class thread_pool {
+
+public:
+  /**
+   * Creates a pool of `threads` threads, including the thread which runs each
+   * job, so `threads - 1` workers are started
+   */
+  explicit thread_pool(
+      std::size_t threads = std::thread::hardware_concurrency())
+      : queues(std::max<std::size_t>(threads, 1)) {
+    workers.reserve(queues.size() - 1);
+    for (std::size_t i = 1; i < queues.size(); ++i) {
+      workers.emplace_back([this, i] { serve(i); });
+    }
+  }
+
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      stopping = true;
+    }
+    started.notify_all();
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+  }
+
+  /**
+   * Number of threads which execute each job
+   */
+  std::size_t size() const noexcept { return queues.size(); }
+
+  /**
+   * Calls `f(i)` for every chunk `i` in [0, chunks), returning once every
+   * chunk has been executed
+   */
+  template <typename function> void run(std::size_t chunks, function &f) {
+    std::lock_guard<std::mutex> serial{running};
+    const std::size_t n = queues.size();
+    for (std::size_t i = 0; i < n; ++i) {
+      queues[i].range.store(pack(chunks * i / n, chunks * (i + 1) / n),
+                            std::memory_order_relaxed);
+    }
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      job = {&invoke<function>, &f};
+      active = n - 1;
+      ++generation;
+    }
+    started.notify_all();
+    work(0);
+    std::unique_lock<std::mutex> lock{mutex};
+    finished.wait(lock, [this] { return active == 0; });
+  }
+
+private:
+  /**
+   * Chunks [begin, end) yet to be executed by a thread, packed into a single
+   * word so that the owner and thieves may update them with a single
+   * compare-and-swap. Each queue has its own cache line.
+   */
+  struct alignas(64) queue {
+    std::atomic<std::uint64_t> range{0};
+  };
+
+  struct task {
+    void (*call)(void *, std::size_t) noexcept;
+    void *context;
+  };
+
+  std::vector<queue> queues;
+  std::vector<std::thread> workers;
+  std::mutex running;
+  std::mutex mutex;
+  std::condition_variable started;
+  std::condition_variable finished;
+  task job{nullptr, nullptr};
+  std::size_t active{0};
+  std::size_t generation{0};
+  bool stopping{false};
+
+  template <typename function>
+  static void invoke(void *context, std::size_t chunk) noexcept {
+    (*static_cast<function *>(context))(chunk);
+  }
+
+  constexpr static std::uint64_t pack(std::uint64_t begin,
+                                      std::uint64_t end) noexcept {
+    return begin << 32 | end;
+  }
+
+  /**
+   * Takes the first chunk of `q` into `chunk`, if any remain
+   */
+  static bool pop(queue &q, std::size_t &chunk) noexcept {
+    std::uint64_t range = q.range.load(std::memory_order_acquire);
+    for (;;) {
+      const std::uint64_t begin = range >> 32;
+      const std::uint64_t end = range & 0xffffffff;
+      if (begin >= end) {
+        return false;
+      }
+      if (q.range.compare_exchange_weak(range, pack(begin + 1, end),
+                                        std::memory_order_acq_rel)) {
+        chunk = begin;
+        return true;
+      }
+    }
+  }
+
+  /**
+   * Takes the second half of the chunks of another thread, executing the
+   * first of them and queueing the rest for thread `i`
+   */
+  bool steal(std::size_t i, std::size_t &chunk) noexcept {
+    const std::size_t n = queues.size();
+    for (std::size_t k = 1; k < n; ++k) {
+      queue &victim = queues[(i + k) % n];
+      std::uint64_t range = victim.range.load(std::memory_order_acquire);
+      for (;;) {
+        const std::uint64_t begin = range >> 32;
+        const std::uint64_t end = range & 0xffffffff;
+        if (begin >= end) {
+          break;
+        }
+        const std::uint64_t middle = begin + (end - begin) / 2;
+        if (victim.range.compare_exchange_weak(range, pack(begin, middle),
+                                               std::memory_order_acq_rel)) {
+          chunk = middle;
+          queues[i].range.store(pack(middle + 1, end),
+                                std::memory_order_release);
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  void work(std::size_t i) noexcept {
+    std::size_t chunk = 0;
+    while (pop(queues[i], chunk) || steal(i, chunk)) {
+      job.call(job.context, chunk);
+    }
+  }
+
+  void serve(std::size_t i) {
+    std::size_t seen = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        started.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) {
+          return;
+        }
+        seen = generation;
+      }
+      work(i);
+      std::lock_guard<std::mutex> lock{mutex};
+      if (--active == 0) {
+        finished.notify_one();
+      }
+    }
+  }
+};
+
+/**
+ * Number of records matched by each chunk of a parallel match. Chunks are a
+ * multiple of 512 records, so the results of each chunk fill whole 64-byte
+ * lines of a 64-byte aligned bitmap and threads never write to the same line.
+ */
+constexpr static const std::size_t parallel_chunk_size = 4096;
+
+namespace {
+
+/**
+ * Matches the records of chunk `chunk` against `regex`, writing one bit per
+ * record into `results`
+ */
+template <typename regex, typename record_type>
+void match_chunk(const record_type *records, std::size_t count,
+                 std::uint64_t *results, std::size_t chunk) noexcept {
+  const std::size_t begin = chunk * parallel_chunk_size;
+  const std::size_t end = std::min(count, begin + parallel_chunk_size);
+  for (std::size_t word = begin; word < end; word += 64) {
+    const std::size_t last = std::min(end, word + 64);
+    std::uint64_t bits = 0;
+    for (std::size_t i = word; i < last; ++i) {
+      bits |= std::uint64_t{regex_match<regex>(records[i])} << (i - word);
+    }
+    results[word / 64] = bits;
+  }
+}
+
+} // anonymous namespace
+
+/**
+ * Number of 64-bit words of the bitmap holding the results of matching
+ * `count` records in parallel
+ */
+constexpr std::size_t parallel_result_words(std::size_t count) noexcept {
+  return (count + 63) / 64;
+}
+
+/**
+ * Determines whether each of `count` records (e.g. `std::string_view`s)
+ * matches `regex`, setting bit `i % 64` of `results[i / 64]` if record `i`
+ * matches. Records are matched in chunks of `parallel_chunk_size` by the
+ * threads of `pool`, and unused bits of the last word are cleared.
+ *
+ * Note: `results` must hold `parallel_result_words(count)` words, and should be
+ *       64-byte aligned so that no two threads write to the same cache line.
+ */
+template <typename regex, typename record_type>
+void regex_match_parallel(const record_type *records, std::size_t count,
+                          std::uint64_t *results, thread_pool &pool) {
+  auto match = [=](std::size_t chunk) noexcept {
+    match_chunk<regex>(records, count, results, chunk);
+  };
+  pool.run((count + parallel_chunk_size - 1) / parallel_chunk_size, match);
+}
+
+template <typename regex, typename records_type>
+void regex_match_parallel(const records_type &records, std::uint64_t *results,
+                          thread_pool &pool) {
+  regex_match_parallel<regex>(records.data(), records.size(), results, pool);
+}
+
+#if defined(SCRY_EXECUTION_POLICY)
+
+/**
+ * Determines whether each of `count` records matches `regex` as above, with
+ * chunks scheduled by a standard execution policy rather than a pool
+ */
+template <typename regex, typename policy, typename record_type,
+          typename = std::enable_if_t<
+              std::is_execution_policy_v<std::decay_t<policy>>>>
+void regex_match_parallel(policy &&exec, const record_type *records,
+                          std::size_t count, std::uint64_t *results) {
+  std::vector<std::size_t> chunks(
+      (count + parallel_chunk_size - 1) / parallel_chunk_size);
+  for (std::size_t i = 0; i < chunks.size(); ++i) {
+    chunks[i] = i;
+  }
+  std::for_each(std::forward<policy>(exec), chunks.begin(), chunks.end(),
+                [=](std::size_t chunk) noexcept {
+                  match_chunk<regex>(records, count, results, chunk);
+                });
+}
+
+template <typename regex, typename policy, typename records_type,
+          typename = std::enable_if_t<
+              std::is_execution_policy_v<std::decay_t<policy>>>>
+void regex_match_parallel(policy &&exec, const records_type &records,
+                          std::uint64_t *results) {
+  regex_match_parallel<regex>(std::forward<policy>(exec), records.data(),
+                              records.size(), results);
+}
+
+#endif
+
+} // namespace scry
@@ -3,6 +3,7 @@
 #include "definitions.hpp"
 #include "regex.hpp"
 #include "traits.hpp"
+#include "utf8.hpp"
 #include "util.hpp"
 
 namespace scry {
@@ -21,8 +22,14 @@ template <std::size_t n, typename nested> struct at_most;
 template <typename...> struct any_of;
 template <typename...> struct none_of;
 template <char lower, char upper> struct range {
+  static_assert(static_cast<unsigned char>(lower) <=
+                    static_cast<unsigned char>(upper),
+                "Invalid range expression");
+};
+template <char32_t lower, char32_t upper> struct code_points {
   static_assert(lower <= upper, "Invalid range expression");
 };
+template <typename... ranges> struct utf8;
 
 namespace cc {
 
@@ -46,6 +53,22 @@ using word = any_of<alnum, symbol<'_'>>;
 
 } // namespace ast
 
+/**
+ * Determines the byte sequences accepting a UTF-8 class
+ */
+template <typename ast> struct utf8_sequences_of;
+
+template <char32_t... lower, char32_t... upper>
+struct utf8_sequences_of<ast::utf8<ast::code_points<lower, upper>...>> {
+  constexpr static utf8::byte_sequences make() noexcept {
+    utf8::code_point_set set{};
+    (set.insert(lower, upper), ...);
+    return utf8::byte_sequences::of(set);
+  }
+  constexpr static const utf8::byte_sequences value = make();
+  static_assert(!value.overflow, "UTF-8 class is too complex");
+};
+
 namespace {
 
 /**
@@ -62,6 +85,11 @@ namespace {
  */
 template <char c> struct token;
 
+/**
+ * Helper struct to convert UTF-8 encoded non-ASCII characters into types
+ */
+template <char32_t c> struct wide_token;
+
 /**
  * Helper struct to convert number values into types
  */
@@ -492,6 +520,47 @@ struct parse_brkex<
   using unused = typename brkex::unused;
 };
 
+/**
+ * Handle non-ASCII characters
+ */
+template <typename... parts, char32_t c, typename... tokens>
+struct parse_brkex<list<ast::symbol<'['>, parts...>,
+                   list<wide_token<c>, tokens...>> {
+  using brkex =
+      parse_brkex<list<ast::symbol<'['>, parts..., ast::code_points<c, c>>,
+                  list<tokens...>>;
+  using type = typename brkex::type;
+  using unused = typename brkex::unused;
+};
+
+/**
+ * Helper struct to get the code point at the end of a range expression
+ */
+template <typename ast> struct code_point_of;
+
+template <char c> struct code_point_of<ast::symbol<c>> {
+  constexpr static const char32_t value = static_cast<unsigned char>(c);
+};
+
+template <char32_t c> struct code_point_of<ast::code_points<c, c>> {
+  constexpr static const char32_t value = c;
+};
+
+/**
+ * Handle range expressions with a non-ASCII upper limit
+ */
+template <typename... asts, char32_t c, typename... tokens>
+struct parse_brkex<list<ast::symbol<'['>, asts...>,
+                   list<token<'-'>, wide_token<c>, tokens...>> {
+  using init_asts = typename init<list<ast::symbol<'['>, asts...>>::type;
+  using last_ast = typename last<list<asts...>>::type;
+  using new_ast = ast::code_points<code_point_of<last_ast>::value, c>;
+  using new_asts = typename append<init_asts, new_ast>::type;
+  using brkex = parse_brkex<new_asts, list<tokens...>>;
+  using type = typename brkex::type;
+  using unused = typename brkex::unused;
+};
+
 /**
  * Handle close-bracket character (']') for matching lists
  */
@@ -531,6 +600,25 @@ struct parse_regex<ast::sequence<asts...>, list<token<c>, tokens...>> {
                                     list<tokens...>>::type;
 };
 
+/**
+ * Handle non-ASCII characters, which are the sequence of their UTF-8 bytes
+ */
+template <char32_t c, typename sequence> struct utf8_literal;
+
+template <char32_t c, std::size_t... i>
+struct utf8_literal<c, std::index_sequence<i...>> {
+  using type = ast::sequence<
+      ast::symbol<static_cast<char>(utf8::encoded_byte(c, i))>...>;
+};
+
+template <typename... asts, char32_t c, typename... tokens>
+struct parse_regex<ast::sequence<asts...>, list<wide_token<c>, tokens...>> {
+  using literal = typename utf8_literal<
+      c, std::make_index_sequence<utf8::encoded_length(c)>>::type;
+  using type = typename parse_regex<ast::sequence<asts..., literal>,
+                                    list<tokens...>>::type;
+};
+
 /**
  * Handle dot character ('.')
  */
@@ -650,6 +738,254 @@ struct parse_regex<ast::sequence<asts...>, list<token<'['>, tokens...>> {
                            typename brkex::unused>::type;
 };
 
+/**
+ * TEMPLATES FOR UTF-8 MODE
+ *
+ * In UTF-8 mode, the bytes of each non-ASCII character of the pattern are
+ * grouped into a single `wide_token` before parsing, and after parsing every
+ * class which may accept a non-ASCII character is widened into an `ast::utf8`
+ * accepting whole code points.
+ */
+
+/**
+ * Groups the bytes of non-ASCII characters into `wide_token`s
+ */
+template <typename done, typename tokens> struct group_utf8;
+
+template <std::size_t length, typename done, typename tokens>
+struct group_code_point;
+
+template <typename... done> struct group_utf8<list<done...>, list<>> {
+  using type = list<done...>;
+};
+
+template <typename... done, char c, typename... tokens>
+struct group_utf8<list<done...>, list<token<c>, tokens...>> {
+  constexpr static const std::size_t length =
+      utf8::sequence_length(static_cast<unsigned char>(c));
+  static_assert(length != 0, "Invalid UTF-8 in pattern");
+  using type = typename group_code_point<length, list<done...>,
+                                         list<token<c>, tokens...>>::type;
+};
+
+template <typename... done, char c, typename... tokens>
+struct group_code_point<1, list<done...>, list<token<c>, tokens...>> {
+  using type =
+      typename group_utf8<list<done..., token<c>>, list<tokens...>>::type;
+};
+
+template <char... cs> struct decode_tokens {
+  constexpr static const unsigned char bytes[] = {
+      static_cast<unsigned char>(cs)...};
+  constexpr static const char32_t value = utf8::decode(bytes, sizeof...(cs));
+  static_assert(value <= utf8::max_code_point, "Invalid UTF-8 in pattern");
+};
+
+template <typename... done, char c0, char c1, typename... tokens>
+struct group_code_point<2, list<done...>,
+                        list<token<c0>, token<c1>, tokens...>> {
+  using type = typename group_utf8<
+      list<done..., wide_token<decode_tokens<c0, c1>::value>>,
+      list<tokens...>>::type;
+};
+
+template <typename... done, char c0, char c1, char c2, typename... tokens>
+struct group_code_point<3, list<done...>,
+                        list<token<c0>, token<c1>, token<c2>, tokens...>> {
+  using type = typename group_utf8<
+      list<done..., wide_token<decode_tokens<c0, c1, c2>::value>>,
+      list<tokens...>>::type;
+};
+
+template <typename... done, char c0, char c1, char c2, char c3,
+          typename... tokens>
+struct group_code_point<
+    4, list<done...>,
+    list<token<c0>, token<c1>, token<c2>, token<c3>, tokens...>> {
+  using type = typename group_utf8<
+      list<done..., wide_token<decode_tokens<c0, c1, c2, c3>::value>>,
+      list<tokens...>>::type;
+};
+
+/**
+ * Determines the code points accepted by a class
+ */
+template <typename ast> struct code_points_of;
+
+template <char c> struct code_points_of<ast::symbol<c>> {
+  constexpr static utf8::code_point_set make() noexcept {
+    utf8::code_point_set result{};
+    result.insert(static_cast<unsigned char>(c), static_cast<unsigned char>(c));
+    return result;
+  }
+  constexpr static const utf8::code_point_set value = make();
+};
+
+template <char lower, char upper>
+struct code_points_of<ast::range<lower, upper>> {
+  constexpr static utf8::code_point_set make() noexcept {
+    utf8::code_point_set result{};
+    result.insert(static_cast<unsigned char>(lower),
+                  static_cast<unsigned char>(upper));
+    return result;
+  }
+  constexpr static const utf8::code_point_set value = make();
+};
+
+template <char32_t lower, char32_t upper>
+struct code_points_of<ast::code_points<lower, upper>> {
+  constexpr static utf8::code_point_set make() noexcept {
+    utf8::code_point_set result{};
+    result.insert(lower, upper);
+    return result;
+  }
+  constexpr static const utf8::code_point_set value = make();
+};
+
+template <> struct code_points_of<ast::any> {
+  constexpr static const utf8::code_point_set value =
+      utf8::code_point_set::all();
+};
+
+template <typename... nested> struct code_points_of<ast::any_of<nested...>> {
+  constexpr static utf8::code_point_set make() noexcept {
+    utf8::code_point_set result{};
+    (result.insert(code_points_of<nested>::value), ...);
+    return result;
+  }
+  constexpr static const utf8::code_point_set value = make();
+};
+
+template <typename... nested> struct code_points_of<ast::none_of<nested...>> {
+  constexpr static const utf8::code_point_set value =
+      code_points_of<ast::any_of<nested...>>::value.complement();
+};
+
+/**
+ * Builds the `ast::utf8` accepting the code points of a class
+ */
+template <typename node, typename sequence = std::make_index_sequence<
+                              code_points_of<node>::value.size>>
+struct utf8_class;
+
+template <typename node, std::size_t... i>
+struct utf8_class<node, std::index_sequence<i...>> {
+  constexpr static const utf8::code_point_set &set =
+      code_points_of<node>::value;
+  static_assert(!set.overflow, "UTF-8 class is too complex");
+  using type =
+      ast::utf8<ast::code_points<set.ranges[i].lower, set.ranges[i].upper>...>;
+};
+
+/**
+ * Widens the classes of an AST which may accept non-ASCII characters
+ */
+template <typename ast> struct widen_utf8 { using type = ast; };
+
+template <> struct widen_utf8<ast::any> {
+  using type = typename utf8_class<ast::any>::type;
+};
+
+template <typename... nested> struct widen_utf8<ast::any_of<nested...>> {
+  using type = typename std::conditional<
+      code_points_of<ast::any_of<nested...>>::value.ascii(),
+      ast::any_of<nested...>,
+      typename utf8_class<ast::any_of<nested...>>::type>::type;
+};
+
+template <typename... nested> struct widen_utf8<ast::none_of<nested...>> {
+  using type = typename utf8_class<ast::none_of<nested...>>::type;
+};
+
+template <typename nested> struct widen_utf8<ast::zero_or_more<nested>> {
+  using type = ast::zero_or_more<typename widen_utf8<nested>::type>;
+};
+
+template <std::size_t n, typename nested>
+struct widen_utf8<ast::exactly<n, nested>> {
+  using type = ast::exactly<n, typename widen_utf8<nested>::type>;
+};
+
+template <std::size_t n, typename nested>
+struct widen_utf8<ast::at_least<n, nested>> {
+  using type = ast::at_least<n, typename widen_utf8<nested>::type>;
+};
+
+template <std::size_t n, typename nested>
+struct widen_utf8<ast::at_most<n, nested>> {
+  using type = ast::at_most<n, typename widen_utf8<nested>::type>;
+};
+
+/**
+ * Determines whether a quantified class may stay byte-level because it is
+ * followed by an ASCII symbol or the end of the pattern. For valid UTF-8 input
+ * such a class only ever stops at the boundary of a character, so accepting
+ * bytes rather than code points accepts the same input while keeping the
+ * single-byte fast paths (see `optimise_until`).
+ */
+template <typename ast, typename next> struct keeps_bytes : no {};
+
+template <typename next> struct stops_at_boundary : no {};
+
+template <char c> struct stops_at_boundary<ast::symbol<c>> : yes {};
+
+template <> struct stops_at_boundary<ast::right_anchor> : yes {};
+
+template <> struct stops_at_boundary<list<>> : yes {};
+
+template <typename next>
+struct keeps_bytes<ast::zero_or_more<ast::any>, next>
+    : stops_at_boundary<next> {};
+
+template <typename... nested, typename next>
+struct keeps_bytes<ast::zero_or_more<ast::none_of<nested...>>, next> {
+  constexpr static const bool value =
+      code_points_of<ast::any_of<nested...>>::value.ascii() &&
+      stops_at_boundary<next>::value;
+};
+
+template <typename done, typename asts> struct widen_sequence;
+
+template <typename... done>
+struct widen_sequence<ast::sequence<done...>, list<>> {
+  using type = ast::sequence<done...>;
+};
+
+template <typename... done, typename head>
+struct widen_sequence<ast::sequence<done...>, list<head>> {
+  using widened =
+      typename std::conditional<keeps_bytes<head, list<>>::value, head,
+                                typename widen_utf8<head>::type>::type;
+  using type = ast::sequence<done..., widened>;
+};
+
+template <typename... done, typename head, typename next, typename... tail>
+struct widen_sequence<ast::sequence<done...>, list<head, next, tail...>> {
+  using widened =
+      typename std::conditional<keeps_bytes<head, next>::value, head,
+                                typename widen_utf8<head>::type>::type;
+  using type = typename widen_sequence<ast::sequence<done..., widened>,
+                                       list<next, tail...>>::type;
+};
+
+template <typename... nested> struct widen_utf8<ast::sequence<nested...>> {
+  using type =
+      typename widen_sequence<ast::sequence<>, list<nested...>>::type;
+};
+
+/**
+ * Parses a list of tokens, in UTF-8 mode if `utf8` is set
+ */
+template <bool utf8, typename tokens> struct parse_tokens {
+  using type = typename parse_regex<ast::sequence<>, tokens>::type;
+};
+
+template <typename tokens> struct parse_tokens<true, tokens> {
+  using grouped = typename group_utf8<list<>, tokens>::type;
+  using type = typename widen_utf8<
+      typename parse_regex<ast::sequence<>, grouped>::type>::type;
+};
+
 } // anonymous namespace
 
 /**
@@ -657,10 +993,11 @@ struct parse_regex<ast::sequence<asts...>, list<token<'['>, tokens...>> {
  */
 template <typename regex, typename sequence> struct parse_result;
 
-template <const char *cs, const trait_type traits, std::size_t... n>
-struct parse_result<regex<cs, traits>, std::index_sequence<n...>> {
+template <typename regex, std::size_t... n>
+struct parse_result<regex, std::index_sequence<n...>> {
 
   // Validate traits
+  constexpr static const trait_type traits = regex::flags;
   constexpr static const trait_type all_grammars =
       trait::ECMAScript | trait::basic | trait::extended | trait::awk |
       trait::grep | trait::egrep;
@@ -669,8 +1006,9 @@ struct parse_result<regex<cs, traits>, std::index_sequence<n...>> {
                 grammar == trait::extended || grammar == trait::awk ||
                 grammar == trait::grep || grammar == trait::egrep);
 
-  using type = typename parse_regex<
-      ast::sequence<>, list<token<regex<cs, traits>::string::get(n)>...>>::type;
+  using type =
+      typename parse_tokens<(traits & trait::utf8) != 0,
+                            list<token<regex::string::get(n)>...>>::type;
 };
 
 } // namespace scry
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "match.hpp"
+#include "search.hpp"
+
+#include <string>
+#include <string_view>
+
+/**
+ * Declares `name`, a class whose static members match and search for a regex
+ * compiled in a single translation unit by `SCRY_DEFINE_REGEX`. Translation
+ * units calling `name::match` or `name::search` link against the compiled
+ * matcher rather than compiling the regex themselves, so changing them does
+ * not recompile the regex, and changing the regex recompiles one file.
+ *
+ * Matchers are not inlined into their callers, and are not constant
+ * expressions. Input is taken by pointer, `std::string` iterator or
+ * `std::string_view`; other iterators must use `regex_match` and
+ * `regex_search` directly.
+ */
+#define SCRY_DECLARE_REGEX(name)                                               \
+  struct name {                                                                \
+    using string_it = std::string::const_iterator;                             \
+    static bool match(const char *begin, const char *end) noexcept;            \
+    static bool match(string_it begin, string_it end) noexcept;                \
+    static bool match(std::string_view str) noexcept;                          \
+    static scry::sub_match<const char *> search(const char *begin,             \
+                                                const char *end) noexcept;     \
+    static scry::sub_match<string_it> search(string_it begin,                  \
+                                             string_it end) noexcept;          \
+    static scry::sub_match<const char *> search(                               \
+        std::string_view str) noexcept;                                        \
+  }
+
+/**
+ * Compiles the matchers of `name`, declared by `SCRY_DECLARE_REGEX`, for the
+ * regex given by the remaining arguments (which may contain commas, e.g.
+ * `scry::regex<pattern, scry::trait::utf8>`). Must be used exactly once, in
+ * the namespace in which `name` is declared.
+ */
+#define SCRY_DEFINE_REGEX(name, ...)                                           \
+  bool name::match(const char *begin, const char *end) noexcept {              \
+    return scry::regex_match<__VA_ARGS__>(begin, end);                         \
+  }                                                                            \
+  bool name::match(string_it begin, string_it end) noexcept {                  \
+    return scry::regex_match<__VA_ARGS__>(begin, end);                         \
+  }                                                                            \
+  bool name::match(std::string_view str) noexcept {                            \
+    return scry::regex_match<__VA_ARGS__>(str);                                \
+  }                                                                            \
+  scry::sub_match<const char *> name::search(const char *begin,                \
+                                             const char *end) noexcept {       \
+    return scry::regex_search<__VA_ARGS__>(begin, end);                        \
+  }                                                                            \
+  scry::sub_match<name::string_it> name::search(string_it begin,               \
+                                                string_it end) noexcept {      \
+    return scry::regex_search<__VA_ARGS__>(begin, end);                        \
+  }                                                                            \
+  scry::sub_match<const char *> name::search(std::string_view str) noexcept {  \
+    return scry::regex_search<__VA_ARGS__>(str);                               \
+  }                                                                            \
+  static_assert(true, "")
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "definitions.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace scry {
+
+namespace profile {
+
+/**
+ * Whether ops are instrumented with counters. Instrumentation is enabled by
+ * defining `SCRY_PROFILE` before including scry; otherwise every counter update
+ * is discarded at compile-time. Executions in constant expressions are never
+ * recorded.
+ */
+#if defined(SCRY_PROFILE)
+constexpr static const bool enabled = true;
+#else
+constexpr static const bool enabled = false;
+#endif
+
+/**
+ * Counters recorded for a single op
+ *
+ * Note: `probes` and `backtracks` are only recorded by quantifiers. A probe is
+ *       an execution of the quantifier's `next` op, and a backtrack is a probe
+ *       which failed.
+ */
+struct counters {
+  std::uint64_t executions{0};
+  std::uint64_t consumed{0};
+  std::uint64_t probes{0};
+  std::uint64_t backtracks{0};
+};
+
+/**
+ * Counters for an op, identified by the address of its tag and described by
+ * its name
+ */
+struct entry {
+  const void *id{nullptr};
+  const char *name{nullptr};
+  counters count{};
+};
+
+/**
+ * Caller-supplied statistics collected while a `scope` is active. Ops are
+ * recorded in order of first execution, and any ops beyond `capacity` are
+ * accumulated into `overflow`.
+ */
+struct stats {
+  constexpr static const std::size_t capacity = 64;
+
+  entry entries[capacity]{};
+  std::size_t size{0};
+  counters overflow{};
+
+  counters &of(const void *id, const char *name) noexcept {
+    for (std::size_t i = 0; i < size; ++i) {
+      if (entries[i].id == id) {
+        return entries[i].count;
+      }
+    }
+    if (size == capacity) {
+      return overflow;
+    }
+    entries[size].id = id;
+    entries[size].name = name;
+    return entries[size++].count;
+  }
+
+  void reset() noexcept { *this = stats{}; }
+};
+
+/**
+ * Statistics which executions on the current thread are recorded into
+ */
+inline thread_local stats *current = nullptr;
+
+/**
+ * Records executions on the current thread into `target` for the lifetime of
+ * the scope
+ */
+class scope {
+
+public:
+  explicit scope(stats &target) noexcept : previous{current} {
+    current = &target;
+  }
+  scope(const scope &) = delete;
+  scope &operator=(const scope &) = delete;
+  ~scope() noexcept { current = previous; }
+
+private:
+  stats *previous;
+};
+
+/**
+ * Identity of an op. Tags have external linkage, so an op is recorded under
+ * the same id by every translation unit and stats may be merged across them.
+ */
+template <typename op> struct tag { constexpr static const char id = 0; };
+
+template <typename op> constexpr const char *name_of() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+  return __FUNCSIG__;
+#else
+  return __PRETTY_FUNCTION__;
+#endif
+}
+
+template <typename op> SCRY_INLINE counters *of() noexcept {
+  if (stats *target = current) {
+    return &target->of(&tag<op>::id, name_of<op>());
+  }
+  return nullptr;
+}
+
+template <typename op, typename it_type, typename result_type>
+SCRY_INLINE void record_execution(it_type begin, result_type &result) noexcept {
+  if (counters *count = of<op>()) {
+    ++count->executions;
+    if (result) {
+      count->consumed +=
+          static_cast<std::uint64_t>(std::distance(begin, *result));
+    }
+  }
+}
+
+template <typename op> SCRY_INLINE void record_probe(bool accepted) noexcept {
+  if (counters *count = of<op>()) {
+    ++count->probes;
+    count->backtracks += !accepted;
+  }
+}
+
+} // namespace profile
+
+} // namespace scry
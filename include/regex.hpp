@@ -3,12 +3,61 @@
 #include "ct_string.hpp"
 #include "traits.hpp"
 
+#include <type_traits>
+
 namespace scry {
 
 template <const char *cs, const trait_type traits = trait::basic> class regex {
 
 public:
   using string = ct_string<cs>;
+
+  constexpr static const trait_type flags = traits;
 };
 
+/**
+ * Regex keyed on the characters of its pattern rather than the address of an
+ * array holding them, so that the same pattern declared in several places or
+ * translation units is a single type, and is compiled and instantiated once
+ */
+template <const trait_type traits, char... cs> class fixed_regex {
+
+public:
+  using string = fixed_string<cs...>;
+
+  constexpr static const trait_type flags = traits;
+
+  /**
+   * The same pattern with different traits
+   */
+  template <const trait_type other>
+  using with_traits = fixed_regex<other, cs...>;
+};
+
+namespace literals {
+
+/**
+ * Creates a basic regex from a string literal, so that `decltype("a*b"_re)`
+ * names the same type wherever it is written.
+ *
+ * Note: String literal operator templates are a GNU extension, supported by
+ *       GCC and Clang. Elsewhere, spell out `fixed_regex` instead.
+ */
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#if defined(__clang__)
+#pragma GCC diagnostic ignored "-Wgnu-string-literal-operator-template"
+#endif
+template <typename char_type, char_type... cs>
+constexpr auto operator""_re() noexcept {
+  static_assert(std::is_same<char_type, char>::value,
+                "Patterns must be narrow string literals");
+  return fixed_regex<trait::basic, static_cast<char>(cs)...>{};
+}
+#pragma GCC diagnostic pop
+#endif
+
+} // namespace literals
+
 } // namespace scry
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "match.hpp"
+#include "search.hpp"
+
+#include <cstddef>
+#include <string_view>
+
+namespace scry {
+
+/**
+ * Selects one of `regex...` by an id known only at runtime, where the id of
+ * each regex is its index in `regex...`. Each regex is compiled as it would
+ * be by `regex_match` and `regex_search`, and a table of their matchers is
+ * built at compile-time for each iterator type, so running the selected
+ * regex costs one indirect call. Ids outside the registry never match.
+ */
+template <typename... regex> class registry {
+  static_assert(sizeof...(regex) > 0, "registry requires at least one regex");
+
+  template <typename it_type>
+  using matcher = bool (*)(it_type, it_type) noexcept;
+
+  template <typename it_type>
+  using searcher = sub_match<it_type> (*)(it_type, it_type) noexcept;
+
+  template <typename it_type>
+  constexpr static const matcher<it_type> matchers[] = {
+      &regex_match<regex, it_type>...};
+
+  template <typename it_type>
+  constexpr static const searcher<it_type> searchers[] = {
+      &regex_search<regex, it_type>...};
+
+public:
+  /**
+   * Number of regexes, and so the first id outside the registry
+   */
+  constexpr static const std::size_t size = sizeof...(regex);
+
+  /**
+   * Determines whether the whole of [begin, end) matches the regex `id`
+   */
+  template <typename it_type>
+  constexpr static bool match(std::size_t id, it_type begin,
+                              it_type end) noexcept {
+    return id < size && matchers<it_type>[id](begin, end);
+  }
+
+  constexpr static bool match(std::size_t id, std::string_view str) noexcept {
+    return match(id, str.data(), str.data() + str.size());
+  }
+
+  /**
+   * Finds the leftmost match of the regex `id` in [begin, end)
+   */
+  template <typename it_type>
+  constexpr static sub_match<it_type> search(std::size_t id, it_type begin,
+                                             it_type end) noexcept {
+    if (id < size) {
+      return searchers<it_type>[id](begin, end);
+    }
+    return {end, end, false};
+  }
+
+  constexpr static sub_match<const char *>
+  search(std::size_t id, std::string_view str) noexcept {
+    return search(id, str.data(), str.data() + str.size());
+  }
+};
+
+} // namespace scry
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "ct_string.hpp"
+#include "search.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+namespace scry {
+
+namespace {
+
+/**
+ * Part of a format string: either `length` symbols of the format string from
+ * `offset`, or the whole match
+ */
+struct format_segment {
+  std::size_t offset{0};
+  std::size_t length{0};
+  bool match{false};
+};
+
+/**
+ * Parses a format string at compile-time, where "$&" is replaced by the whole
+ * match and "$$" by a single "$"
+ */
+template <const char *format> struct format_result {
+  using string = ct_string<format>;
+
+  struct segments {
+    format_segment values[string::size + 1]{};
+    std::size_t size{0};
+    bool valid{true};
+  };
+
+  constexpr static segments make() noexcept {
+    segments result{};
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < string::size; ++i) {
+      if (string::get(i) != '$') {
+        continue;
+      }
+      if (i + 1 == string::size ||
+          (string::get(i + 1) != '&' && string::get(i + 1) != '$')) {
+        result.valid = false;
+        return result;
+      }
+      // "$$" keeps the second "$" as the start of the next literal
+      if (string::get(i + 1) == '$') {
+        result.values[result.size++] = {begin, i - begin, false};
+        begin = i + 1;
+      } else {
+        result.values[result.size++] = {begin, i - begin, false};
+        result.values[result.size++] = {0, 0, true};
+        begin = i + 2;
+      }
+      ++i;
+    }
+    result.values[result.size++] = {begin, string::size - begin, false};
+    return result;
+  }
+
+  constexpr static const segments value = make();
+
+  static_assert(value.valid, "Invalid format string, \"$\" must be followed by "
+                             "\"&\" or \"$\"");
+
+  template <typename it_type, typename out_type>
+  constexpr static out_type write(const sub_match<it_type> &match,
+                                  out_type out) {
+    for (std::size_t i = 0; i < value.size; ++i) {
+      const format_segment &segment = value.values[i];
+      if (segment.match) {
+        for (it_type it = match.begin; it != match.end; ++it) {
+          *out++ = *it;
+        }
+      } else {
+        for (std::size_t j = 0; j < segment.length; ++j) {
+          *out++ = string::get(segment.offset + j);
+        }
+      }
+    }
+    return out;
+  }
+};
+
+/**
+ * Output iterator which writes into a fixed-size buffer and counts every
+ * symbol written, including those which did not fit
+ */
+class bounded_writer {
+
+public:
+  using iterator_category = std::output_iterator_tag;
+  using value_type = void;
+  using difference_type = std::ptrdiff_t;
+  using pointer = void;
+  using reference = void;
+
+  constexpr bounded_writer(char *buffer, std::size_t size) noexcept
+      : buffer{buffer}, size{size} {}
+
+  constexpr bounded_writer &operator*() noexcept { return *this; }
+  constexpr bounded_writer &operator++() noexcept { return *this; }
+  constexpr bounded_writer &operator++(int) noexcept { return *this; }
+
+  constexpr bounded_writer &operator=(char c) noexcept {
+    if (count < size) {
+      buffer[count] = c;
+    }
+    ++count;
+    return *this;
+  }
+
+  constexpr std::size_t written() const noexcept { return count; }
+
+private:
+  char *buffer;
+  std::size_t size;
+  std::size_t count{0};
+};
+
+} // anonymous namespace
+
+/**
+ * Copies [begin, end) to `out`, replacing every non-overlapping match of
+ * `regex` with `format`, in which "$&" stands for the match and "$$" for "$".
+ * The search resumes one symbol after an empty match.
+ */
+template <typename regex, const char *format, typename it_type,
+          typename out_type>
+constexpr out_type regex_replace(it_type begin, it_type end, out_type out) {
+  const it_type first = begin;
+  while (auto match = search_from<regex>(first, begin, end)) {
+    for (; begin != match.begin; ++begin) {
+      *out++ = *begin;
+    }
+    out = format_result<format>::write(match, out);
+    begin = match.end;
+    if (match.begin == match.end) {
+      if (begin == end) {
+        return out;
+      }
+      *out++ = *begin++;
+    }
+  }
+  for (; begin != end; ++begin) {
+    *out++ = *begin;
+  }
+  return out;
+}
+
+/**
+ * Replaces matches as above into a buffer of `size` symbols, and returns the
+ * size of the whole result. Only the first `size` symbols of the result are
+ * written, so the result was truncated if the returned size exceeds `size`.
+ */
+template <typename regex, const char *format, typename it_type>
+constexpr std::size_t regex_replace(it_type begin, it_type end, char *buffer,
+                                    std::size_t size) noexcept {
+  return regex_replace<regex, format>(begin, end,
+                                      bounded_writer{buffer, size})
+      .written();
+}
+
+template <typename regex, const char *format>
+constexpr std::size_t regex_replace(std::string_view str, char *buffer,
+                                    std::size_t size) noexcept {
+  return regex_replace<regex, format>(str.data(), str.data() + str.size(),
+                                      buffer, size);
+}
+
+} // namespace scry
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "codegen.hpp"
+#include "optimise.hpp"
+#include "parser.hpp"
+#include "regex.hpp"
+#include "util.hpp"
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace scry {
+
+namespace {
+
+/**
+ * Reverses an AST, so that it accepts the reverse of every input the original
+ * accepts. Sequences are reversed and anchors swapped, so that the reversed
+ * AST can be executed on reverse iterators.
+ *
+ * Note: UTF-8 classes are compiled into forward byte sequences, so cannot be
+ *       reversed.
+ */
+template <typename ast> struct reverse_ast { using type = ast; };
+
+template <> struct reverse_ast<ast::left_anchor> {
+  using type = ast::right_anchor;
+};
+
+template <> struct reverse_ast<ast::right_anchor> {
+  using type = ast::left_anchor;
+};
+
+template <> struct reverse_ast<ast::sequence<>> {
+  using type = ast::sequence<>;
+};
+
+template <typename head, typename... tail>
+struct reverse_ast<ast::sequence<head, tail...>> {
+  using type =
+      typename append<typename reverse_ast<ast::sequence<tail...>>::type,
+                      typename reverse_ast<head>::type>::type;
+};
+
+/**
+ * Specialization of `reverse_ast` for between `n` and `n + m` repetitions,
+ * which are parsed as `ast::exactly` followed by `ast::at_most` and must stay
+ * in that order to be normalised as one quantifier (see `normalise_sequence`)
+ */
+template <std::size_t n, std::size_t m, typename nested, typename... tail>
+struct reverse_ast<
+    ast::sequence<ast::exactly<n, nested>, ast::at_most<m, nested>, tail...>> {
+  using reversed = typename reverse_ast<nested>::type;
+  using pair =
+      ast::sequence<ast::exactly<n, reversed>, ast::at_most<m, reversed>>;
+  using type =
+      typename concat<typename reverse_ast<ast::sequence<tail...>>::type,
+                      pair>::type;
+};
+
+template <typename nested> struct reverse_ast<ast::zero_or_more<nested>> {
+  using type = ast::zero_or_more<typename reverse_ast<nested>::type>;
+};
+
+template <std::size_t n, typename nested>
+struct reverse_ast<ast::exactly<n, nested>> {
+  using type = ast::exactly<n, typename reverse_ast<nested>::type>;
+};
+
+template <std::size_t n, typename nested>
+struct reverse_ast<ast::at_least<n, nested>> {
+  using type = ast::at_least<n, typename reverse_ast<nested>::type>;
+};
+
+template <std::size_t n, typename nested>
+struct reverse_ast<ast::at_most<n, nested>> {
+  using type = ast::at_most<n, typename reverse_ast<nested>::type>;
+};
+
+template <typename... ranges> struct reverse_ast<ast::utf8<ranges...>> {
+  static_assert(sizeof...(ranges) != sizeof...(ranges),
+                "UTF-8 classes cannot be reversed");
+};
+
+/**
+ * Determines whether a regex treats its pattern and input as UTF-8
+ */
+template <typename regex> struct is_utf8_regex {
+  constexpr static const bool value = (regex::flags & trait::utf8) != 0;
+};
+
+/**
+ * The optimised AST and op program of a regex compiled in reverse
+ */
+template <typename regex> struct reverse_result {
+  using tree = typename reverse_ast<typename parse_result<
+      regex, std::make_index_sequence<regex::string::size>>::type>::type;
+  using opt_tree = typename optimise_result<tree>::type;
+  using code = typename codegen_result<opt_tree>::type;
+};
+
+template <typename ast> struct is_unbounded : no {};
+
+template <typename nested>
+struct is_unbounded<ast::zero_or_more<nested>> : yes {};
+
+template <std::size_t n, typename nested>
+struct is_unbounded<ast::at_least<n, nested>> : yes {};
+
+template <typename nested, typename until>
+struct is_unbounded<ast::until<nested, until>> : yes {};
+
+/**
+ * Determines whether `next` repeats `head` without bound, as when a sequence
+ * starts with "A\{n,\}" normalised into "A\{n\}A*"
+ */
+template <typename head, typename next> struct is_repeated_by : no {};
+
+template <typename nested>
+struct is_repeated_by<nested, ast::zero_or_more<nested>> : yes {};
+
+template <typename nested, typename until>
+struct is_repeated_by<nested, ast::until<nested, until>> : yes {};
+
+template <std::size_t n, typename nested, typename next>
+struct is_repeated_by<ast::exactly<n, nested>, next>
+    : is_repeated_by<nested, next> {};
+
+template <typename ast> struct starts_unbounded : no {};
+
+template <typename head, typename... tail>
+struct starts_unbounded<ast::sequence<head, tail...>> : is_unbounded<head> {};
+
+template <typename head, typename next, typename... tail>
+struct starts_unbounded<ast::sequence<head, next, tail...>> {
+  constexpr static const bool value =
+      is_unbounded<head>::value || is_repeated_by<head, next>::value;
+};
+
+template <typename ast> struct is_class : no {};
+
+template <char c> struct is_class<ast::symbol<c>> : yes {};
+
+template <char lower, char upper>
+struct is_class<ast::range<lower, upper>> : yes {};
+
+template <typename... nested> struct is_class<ast::any_of<nested...>> : yes {};
+
+template <typename... nested>
+struct is_class<ast::none_of<nested...>> : yes {};
+
+template <typename ast> struct ends_with_class : no {};
+
+template <typename head, typename next, typename... tail>
+struct ends_with_class<ast::sequence<head, next, tail...>>
+    : is_class<typename last<ast::sequence<next, tail...>>::type> {};
+
+/**
+ * Determines whether an optimised AST is cheaper to match in reverse, which is
+ * the case when it starts with an unbounded repetition and ends with a symbol
+ * or class other than ".". Forward, the quantifier must step through the input
+ * before the suffix can be tested, whereas in reverse the suffix rejects most
+ * input immediately and a leading ".*" accepts the rest of the input without
+ * stepping through it.
+ */
+template <typename ast> struct prefers_reverse : no {};
+
+template <typename head, typename... tail>
+struct prefers_reverse<ast::sequence<head, tail...>> {
+  using body = typename std::conditional<
+      std::is_same<typename last<ast::sequence<head, tail...>>::type,
+                   ast::right_anchor>::value,
+      typename init<ast::sequence<head, tail...>>::type,
+      ast::sequence<head, tail...>>::type;
+  constexpr static const bool value =
+      starts_unbounded<ast::sequence<head, tail...>>::value &&
+      ends_with_class<body>::value;
+};
+
+template <typename... tail>
+struct prefers_reverse<ast::sequence<ast::left_anchor, tail...>>
+    : prefers_reverse<ast::sequence<tail...>> {};
+
+/**
+ * Determines whether an iterator may be reversed
+ */
+template <typename it_type> struct is_bidirectional {
+  constexpr static const bool value = std::is_base_of<
+      std::bidirectional_iterator_tag,
+      typename std::iterator_traits<it_type>::iterator_category>::value;
+};
+
+} // anonymous namespace
+
+} // namespace scry
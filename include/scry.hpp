@@ -1,4 +1,18 @@
 #pragma once
 
+#include "bit_parallel.hpp"
+#include "column.hpp"
+#include "dynamic.hpp"
+#include "find.hpp"
+#include "lazy_dfa.hpp"
+#include "lexer.hpp"
+#include "literal_set.hpp"
 #include "match.hpp"
+#include "parallel.hpp"
+#include "precompiled.hpp"
 #include "regex.hpp"
+#include "registry.hpp"
+#include "replace.hpp"
+#include "search.hpp"
+#include "split.hpp"
+#include "utf8.hpp"
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "codegen.hpp"
+#include "first.hpp"
+#include "optimise.hpp"
+#include "parser.hpp"
+#include "regex.hpp"
+#include "reverse.hpp"
+#include "util.hpp"
+
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+namespace scry {
+
+/**
+ * Range of the input matched by a regex, if `matched`
+ */
+template <typename it_type> struct sub_match {
+  it_type begin{};
+  it_type end{};
+  bool matched{false};
+
+  constexpr explicit operator bool() const noexcept { return matched; }
+
+  constexpr typename std::iterator_traits<it_type>::difference_type
+  length() const noexcept {
+    return std::distance(begin, end);
+  }
+};
+
+namespace {
+
+/**
+ * Determines whether an AST may only match at the start of the input
+ */
+template <typename ast> struct is_left_anchored : no {};
+
+template <typename... tail>
+struct is_left_anchored<ast::sequence<ast::left_anchor, tail...>> : yes {};
+
+/**
+ * Finds the first match of the optimised AST `opt_tree` which starts in
+ * [begin, end), where `first` is the start of the whole input and so the only
+ * position at which a left-anchored AST may match. Positions whose symbol
+ * cannot start a match are skipped without executing the program.
+ */
+template <typename opt_tree, typename it_type>
+constexpr sub_match<it_type> search_tree(it_type first, it_type begin,
+                                         it_type end) noexcept {
+  using code = typename prefix_codegen_result<opt_tree>::type;
+  if constexpr (is_left_anchored<opt_tree>::value) {
+    if (begin != first) {
+      return {end, end, false};
+    }
+    if (auto it = op::dispatch<code>(begin, end)) {
+      return {begin, *it, true};
+    }
+  } else {
+    for (;; ++begin) {
+      begin = skip_to_first<code>(begin, end);
+      if (auto it = op::dispatch<code>(begin, end)) {
+        return {begin, *it, true};
+      }
+      if (begin == end) {
+        break;
+      }
+    }
+  }
+  return {end, end, false};
+}
+
+/**
+ * Finds the first match of `regex` which starts in [begin, end)
+ */
+template <typename regex, typename it_type>
+constexpr sub_match<it_type> search_from(it_type first, it_type begin,
+                                         it_type end) noexcept {
+  using tree = typename parse_result<
+      regex, std::make_index_sequence<regex::string::size>>::type;
+  using opt_tree = typename optimise_result<tree>::type;
+  return search_tree<opt_tree>(first, begin, end);
+}
+
+} // anonymous namespace
+
+/**
+ * Finds the leftmost match of `regex` in [begin, end), with quantifiers
+ * accepting as much of the input as they can
+ */
+template <typename regex, typename it_type>
+constexpr sub_match<it_type> regex_search(it_type begin, it_type end) noexcept {
+  return search_from<regex>(begin, begin, end);
+}
+
+template <typename regex>
+constexpr sub_match<const char *> regex_search(std::string_view str) noexcept {
+  return regex_search<regex>(str.data(), str.data() + str.size());
+}
+
+/**
+ * Finds the match of `regex` in [begin, end) which ends last, with quantifiers
+ * accepting as much of the input before that end as they can. The regex is
+ * compiled in reverse and searched for from the end of the input, so input
+ * after the last match is scanned once and input before it not at all.
+ */
+template <typename regex, typename it_type>
+constexpr sub_match<it_type> regex_rsearch(it_type begin,
+                                           it_type end) noexcept {
+  static_assert(!is_utf8_regex<regex>::value,
+                "UTF-8 regexes cannot be searched in reverse");
+  static_assert(is_bidirectional<it_type>::value,
+                "searching in reverse requires bidirectional iterators");
+  using reverse_it = std::reverse_iterator<it_type>;
+  const reverse_it first{end};
+  auto found = search_tree<typename reverse_result<regex>::opt_tree>(
+      first, first, reverse_it{begin});
+  if (found) {
+    return {found.end.base(), found.begin.base(), true};
+  }
+  return {end, end, false};
+}
+
+template <typename regex>
+constexpr sub_match<const char *> regex_rsearch(std::string_view str) noexcept {
+  return regex_rsearch<regex>(str.data(), str.data() + str.size());
+}
+
+} // namespace scry
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "search.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+namespace scry {
+
+/**
+ * Iterates over the pieces of a string between the matches of the delimiter
+ * `regex`. Empty matches of the delimiter are ignored, so there is always one
+ * more piece than there are non-empty delimiters, and pieces may be empty.
+ * A default-constructed iterator is past the last piece.
+ */
+template <typename regex> class split_iterator {
+
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::string_view;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type *;
+  using reference = const value_type &;
+
+  constexpr split_iterator() noexcept = default;
+
+  constexpr split_iterator(const char *begin, const char *end) noexcept
+      : first{begin}, next{begin}, last{end}, pending{true}, ended{false} {
+    ++*this;
+  }
+
+  constexpr reference operator*() const noexcept { return current; }
+  constexpr pointer operator->() const noexcept { return &current; }
+
+  constexpr split_iterator &operator++() noexcept {
+    if (!pending) {
+      ended = true;
+      return *this;
+    }
+    sub_match<const char *> delimiter = find_delimiter();
+    if (delimiter) {
+      current = {next, static_cast<std::size_t>(delimiter.begin - next)};
+      next = delimiter.end;
+    } else {
+      current = {next, static_cast<std::size_t>(last - next)};
+      pending = false;
+    }
+    return *this;
+  }
+
+  constexpr split_iterator operator++(int) noexcept {
+    split_iterator result = *this;
+    ++*this;
+    return result;
+  }
+
+  friend constexpr bool operator==(const split_iterator &left,
+                                   const split_iterator &right) noexcept {
+    if (left.ended || right.ended) {
+      return left.ended && right.ended;
+    }
+    return left.current.data() == right.current.data() &&
+           left.pending == right.pending;
+  }
+
+  friend constexpr bool operator!=(const split_iterator &left,
+                                   const split_iterator &right) noexcept {
+    return !(left == right);
+  }
+
+private:
+  const char *first{nullptr};
+  const char *next{nullptr};
+  const char *last{nullptr};
+  value_type current{};
+  bool pending{false};
+  bool ended{true};
+
+  constexpr sub_match<const char *> find_delimiter() const noexcept {
+    for (const char *begin = next;;) {
+      sub_match<const char *> result = search_from<regex>(first, begin, last);
+      if (!result || result.begin != result.end) {
+        return result;
+      }
+      if (result.end == last) {
+        return {};
+      }
+      begin = result.end + 1;
+    }
+  }
+};
+
+/**
+ * Range of the pieces of a string between the matches of the delimiter
+ * `regex`, which are found lazily as the range is iterated
+ */
+template <typename regex> class split_range {
+
+public:
+  using iterator = split_iterator<regex>;
+
+  constexpr split_range() noexcept = default;
+
+  constexpr explicit split_range(std::string_view str) noexcept : str{str} {}
+
+  constexpr iterator begin() const noexcept {
+    return {str.data(), str.data() + str.size()};
+  }
+  constexpr iterator end() const noexcept { return {}; }
+
+private:
+  std::string_view str{};
+};
+
+/**
+ * Splits a string into the pieces between the matches of the delimiter
+ * `regex`, found lazily. The pieces refer to `str`, which must outlive them.
+ */
+template <typename regex>
+constexpr split_range<regex> regex_split(std::string_view str) noexcept {
+  return split_range<regex>{str};
+}
+
+/**
+ * Splits a string as above, writing every piece to `out`
+ */
+template <typename regex, typename out_type>
+constexpr out_type regex_split(std::string_view str, out_type out) {
+  for (std::string_view piece : regex_split<regex>(str)) {
+    *out++ = piece;
+  }
+  return out;
+}
+
+} // namespace scry
@@ -27,6 +27,21 @@ constexpr static const trait_type awk = 256;
 constexpr static const trait_type grep = 512;
 constexpr static const trait_type egrep = 1024;
 
+/**
+ * Treats patterns and input as UTF-8. Non-ASCII characters in patterns are
+ * single atoms, and ".", non-matching lists and lists containing non-ASCII
+ * characters match whole encoded code points. Input is never decoded; classes
+ * are compiled into sequences of byte ranges instead, so that a class never
+ * matches an invalid sequence in the input.
+ *
+ * Note: Matching is only exact for valid UTF-8 input. A "*" on "." or on a
+ *       non-matching list of ASCII characters, when followed by an ASCII
+ *       symbol or the end of the pattern, accepts any bytes rather than code
+ *       points (see `keeps_bytes`), so e.g. "a.*" matches "a\xff" although
+ *       "a." does not.
+ */
+constexpr static const trait_type utf8 = 2048;
+
 } // namespace trait
 
 } // namespace scry
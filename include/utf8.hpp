@@ -0,0 +1,261 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace scry {
+
+namespace utf8 {
+
+constexpr static const char32_t max_code_point = 0x10FFFF;
+constexpr static const char32_t surrogates_lower = 0xD800;
+constexpr static const char32_t surrogates_upper = 0xDFFF;
+
+/**
+ * Number of bytes in the UTF-8 encoding of a code point
+ */
+constexpr std::size_t encoded_length(char32_t c) noexcept {
+  return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+}
+
+/**
+ * Number of bytes in a UTF-8 sequence starting with `lead`, or 0 if `lead`
+ * cannot start a sequence
+ */
+constexpr std::size_t sequence_length(unsigned char lead) noexcept {
+  return lead < 0x80   ? 1
+         : lead < 0xC2 ? 0
+         : lead < 0xE0 ? 2
+         : lead < 0xF0 ? 3
+         : lead < 0xF5 ? 4
+                       : 0;
+}
+
+/**
+ * The `i`-th byte of the UTF-8 encoding of a code point
+ */
+constexpr unsigned char encoded_byte(char32_t c, std::size_t i) noexcept {
+  const std::size_t length = encoded_length(c);
+  if (length == 1) {
+    return static_cast<unsigned char>(c);
+  }
+  const std::size_t shift = 6 * (length - 1 - i);
+  if (i == 0) {
+    constexpr unsigned char leads[] = {0, 0, 0xC0, 0xE0, 0xF0};
+    return static_cast<unsigned char>(leads[length] | (c >> shift));
+  }
+  return static_cast<unsigned char>(0x80 | ((c >> shift) & 0x3F));
+}
+
+/**
+ * Decodes a UTF-8 sequence of `length` bytes, or returns a value above
+ * `max_code_point` if the sequence is invalid
+ */
+constexpr char32_t decode(const unsigned char *bytes,
+                          std::size_t length) noexcept {
+  constexpr char32_t invalid = max_code_point + 1;
+  if (length == 0 || sequence_length(bytes[0]) != length) {
+    return invalid;
+  }
+  constexpr unsigned char masks[] = {0, 0x7F, 0x1F, 0x0F, 0x07};
+  char32_t result = bytes[0] & masks[length];
+  for (std::size_t i = 1; i < length; ++i) {
+    if ((bytes[i] & 0xC0) != 0x80) {
+      return invalid;
+    }
+    result = (result << 6) | (bytes[i] & 0x3F);
+  }
+  if (encoded_length(result) != length || result > max_code_point ||
+      (surrogates_lower <= result && result <= surrogates_upper)) {
+    return invalid;
+  }
+  return result;
+}
+
+/**
+ * Set of code points stored as sorted, disjoint and non-adjacent ranges
+ */
+struct code_point_set {
+  constexpr static const std::size_t capacity = 128;
+
+  struct range {
+    char32_t lower{0};
+    char32_t upper{0};
+  };
+
+  range ranges[capacity]{};
+  std::size_t size{0};
+  bool overflow{false};
+
+  constexpr void insert(char32_t lower, char32_t upper) noexcept {
+    if (lower > upper) {
+      return;
+    }
+    // Find the ranges which overlap or touch [lower, upper] and merge them
+    std::size_t first = 0;
+    while (first < size && ranges[first].upper + 1 < lower) {
+      ++first;
+    }
+    std::size_t last = first;
+    while (last < size && ranges[last].lower <= upper + 1) {
+      lower = ranges[last].lower < lower ? ranges[last].lower : lower;
+      upper = ranges[last].upper > upper ? ranges[last].upper : upper;
+      ++last;
+    }
+    if (first == last) {
+      if (size == capacity) {
+        overflow = true;
+        return;
+      }
+      for (std::size_t i = size; i > first; --i) {
+        ranges[i] = ranges[i - 1];
+      }
+      ++size;
+    } else {
+      for (std::size_t i = last; i < size; ++i) {
+        ranges[first + 1 + i - last] = ranges[i];
+      }
+      size -= last - first - 1;
+    }
+    ranges[first] = {lower, upper};
+  }
+
+  constexpr void insert(const code_point_set &other) noexcept {
+    for (std::size_t i = 0; i < other.size; ++i) {
+      insert(other.ranges[i].lower, other.ranges[i].upper);
+    }
+    overflow |= other.overflow;
+  }
+
+  /**
+   * Code points which are not in the set, excluding surrogates
+   */
+  constexpr code_point_set complement() const noexcept {
+    code_point_set result{};
+    char32_t next = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+      if (next < ranges[i].lower) {
+        result.insert(next, ranges[i].lower - 1);
+      }
+      next = ranges[i].upper + 1;
+    }
+    if (next <= max_code_point) {
+      result.insert(next, max_code_point);
+    }
+    result.overflow |= overflow;
+    return result.without_surrogates();
+  }
+
+  constexpr code_point_set without_surrogates() const noexcept {
+    code_point_set result{};
+    for (std::size_t i = 0; i < size; ++i) {
+      const range r = ranges[i];
+      if (r.upper < surrogates_lower || r.lower > surrogates_upper) {
+        result.insert(r.lower, r.upper);
+        continue;
+      }
+      if (r.lower < surrogates_lower) {
+        result.insert(r.lower, surrogates_lower - 1);
+      }
+      if (r.upper > surrogates_upper) {
+        result.insert(surrogates_upper + 1, r.upper);
+      }
+    }
+    result.overflow |= overflow;
+    return result;
+  }
+
+  constexpr bool ascii() const noexcept {
+    return size == 0 || ranges[size - 1].upper < 0x80;
+  }
+
+  constexpr static code_point_set all() noexcept {
+    return code_point_set{}.complement();
+  }
+};
+
+/**
+ * Sequence of byte ranges accepting the UTF-8 encodings of a range of code
+ * points
+ */
+struct byte_sequence {
+  std::size_t length{0};
+  unsigned char lower[4]{};
+  unsigned char upper[4]{};
+};
+
+/**
+ * Byte sequences accepting the UTF-8 encodings of a set of code points. The
+ * sequences are ordered by the code points they accept, so single-byte
+ * sequences come first, and at most one sequence accepts any input.
+ */
+struct byte_sequences {
+  constexpr static const std::size_t capacity = 512;
+
+  byte_sequence values[capacity]{};
+  std::size_t size{0};
+  bool overflow{false};
+
+  /**
+   * Splits [lower, upper] until each part has encodings of the same length
+   * which differ only in a suffix of continuation bytes covering their whole
+   * range, so that each part is accepted by a single sequence of byte ranges
+   */
+  constexpr void insert(char32_t lower, char32_t upper) noexcept {
+    constexpr char32_t limits[] = {0x7F, 0x7FF, 0xFFFF};
+    for (char32_t limit : limits) {
+      if (lower <= limit && limit < upper) {
+        insert(lower, limit);
+        insert(limit + 1, upper);
+        return;
+      }
+    }
+    for (std::size_t i = 1; i < encoded_length(lower); ++i) {
+      const char32_t mask = (char32_t{1} << (6 * i)) - 1;
+      if ((lower & ~mask) != (upper & ~mask)) {
+        if ((lower & mask) != 0) {
+          insert(lower, lower | mask);
+          insert((lower | mask) + 1, upper);
+          return;
+        }
+        if ((upper & mask) != mask) {
+          insert(lower, (upper & ~mask) - 1);
+          insert(upper & ~mask, upper);
+          return;
+        }
+      }
+    }
+    if (size == capacity) {
+      overflow = true;
+      return;
+    }
+    byte_sequence &sequence = values[size++];
+    sequence.length = encoded_length(lower);
+    for (std::size_t i = 0; i < sequence.length; ++i) {
+      sequence.lower[i] = encoded_byte(lower, i);
+      sequence.upper[i] = encoded_byte(upper, i);
+    }
+  }
+
+  constexpr std::size_t single_bytes() const noexcept {
+    std::size_t result = 0;
+    while (result < size && values[result].length == 1) {
+      ++result;
+    }
+    return result;
+  }
+
+  constexpr static byte_sequences of(const code_point_set &set) noexcept {
+    byte_sequences result{};
+    const code_point_set valid = set.without_surrogates();
+    for (std::size_t i = 0; i < valid.size; ++i) {
+      result.insert(valid.ranges[i].lower, valid.ranges[i].upper);
+    }
+    result.overflow |= valid.overflow;
+    return result;
+  }
+};
+
+} // namespace utf8
+
+} // namespace scry
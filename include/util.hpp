@@ -1,8 +1,14 @@
 #pragma once
 
+#include "definitions.hpp"
+
 #include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace scry {
 
@@ -38,17 +44,18 @@ template <typename type> struct maybe {
     return *this;
   }
   SCRY_INLINE constexpr type &operator*() noexcept { return value; }
-  SCRY_INLINE constexpr bool operator==(const maybe<type> &other) {
-    return !(*this || other) || (*this && other && value == other.value);
+  SCRY_INLINE constexpr bool operator==(const maybe<type> &other) const {
+    return !(some || other.some) ||
+           (some && other.some && value == other.value);
   }
-  SCRY_INLINE constexpr bool operator==(const type &other) {
-    return !(*this || other) || (*this && other && value == other);
+  SCRY_INLINE constexpr bool operator==(const type &other) const {
+    return some && value == other;
   }
-  SCRY_INLINE constexpr bool operator>(const maybe<type> &other) {
-    return !(*this || other) || (*this && other && value > other.value);
+  SCRY_INLINE constexpr bool operator>(const maybe<type> &other) const {
+    return !(some || other.some) || (some && other.some && value > other.value);
   }
-  SCRY_INLINE constexpr bool operator>(const type &other) {
-    return !(*this || other) || (*this && other && value > other);
+  SCRY_INLINE constexpr bool operator>(const type &other) const {
+    return some && value > other;
   }
 };
 
@@ -102,6 +109,14 @@ struct append<list<args...>, arg> {
   using type = list<args..., arg>;
 };
 
+template <typename left, typename right> struct concat;
+
+template <template <typename...> typename list, typename... left,
+          typename... right>
+struct concat<list<left...>, list<right...>> {
+  using type = list<left..., right...>;
+};
+
 template <typename list> struct last;
 
 template <template <typename...> typename list, typename arg>
@@ -145,4 +160,87 @@ template <typename list> struct init {
   using type = typename drop_right<list, 1>::type;
 };
 
+/**
+ * Value of a code unit as an unsigned integer. Symbols are compared by value,
+ * so that bytes at or above 0x80 compare the same whether or not `char` is
+ * signed, and so that input of any code-unit type (e.g. `char16_t`, `wchar_t`
+ * or `std::uint8_t`) may be matched without transcoding it.
+ *
+ * Note: Symbols and ranges in the AST are `char`s, so a pattern can only name
+ *       units from 0 to 0xFF. A unit above 0xFF, e.g. U+0164 in UTF-16, never
+ *       equals a symbol or falls in a range, and is only accepted by "." and
+ *       non-matching lists.
+ */
+template <typename unit>
+SCRY_INLINE constexpr typename std::make_unsigned<unit>::type
+unit_value(unit u) noexcept {
+  return static_cast<typename std::make_unsigned<unit>::type>(u);
+}
+
+/**
+ * Determines whether the code units of an iterator are bytes, as required by
+ * engines which index tables by symbol
+ */
+template <typename it_type> struct has_byte_units {
+  constexpr static const bool value =
+      sizeof(typename std::iterator_traits<it_type>::value_type) == 1;
+};
+
+/**
+ * Determines whether an iterator is a pointer to bytes other than `char`
+ * (e.g. `std::uint8_t`), which may be scanned with `memchr` at runtime
+ */
+template <typename it_type> struct is_byte_pointer {
+  constexpr static const bool value =
+      std::is_pointer<it_type>::value && has_byte_units<it_type>::value;
+};
+
+/**
+ * Determines whether an iterator refers to contiguous storage of `char`s, in
+ * which case scanning may be delegated to the standard library
+ */
+template <typename it_type> struct is_contiguous {
+  constexpr static const bool value =
+      std::is_same<it_type, char *>::value ||
+      std::is_same<it_type, const char *>::value ||
+      std::is_same<it_type, std::string::iterator>::value ||
+      std::is_same<it_type, std::string::const_iterator>::value ||
+      std::is_same<it_type, std::vector<char>::iterator>::value ||
+      std::is_same<it_type, std::vector<char>::const_iterator>::value;
+};
+
+/**
+ * Finds the first occurrence of `c` in [begin, end), returning end if there is
+ * none. Contiguous ranges are scanned with `std::char_traits<char>::find`,
+ * which is `memchr` at runtime and remains usable in constant expressions.
+ * Other byte pointers are scanned with `memchr` outside constant expressions.
+ */
+template <typename it_type>
+SCRY_INLINE constexpr it_type find_symbol(it_type begin, it_type end,
+                                          char c) noexcept {
+  if constexpr (is_contiguous<it_type>::value) {
+    if (begin == end) {
+      return end;
+    }
+    const char *data = &*begin;
+    const char *found = std::char_traits<char>::find(
+        data, static_cast<std::size_t>(end - begin), c);
+    return found ? begin + (found - data) : end;
+  } else {
+    if constexpr (is_byte_pointer<it_type>::value) {
+      if (!SCRY_CONSTANT_EVALUATED() && begin != end) {
+        const void *found = std::memchr(
+            begin, unit_value(c), static_cast<std::size_t>(end - begin));
+        return found ? begin + (static_cast<const unsigned char *>(found) -
+                                reinterpret_cast<const unsigned char *>(begin))
+                     : end;
+      }
+    }
+    while (begin != end && unit_value(*begin) != unit_value(c)) {
+      ++begin;
+    }
+    return begin;
+  }
+}
+
 } // namespace scry
@@ -0,0 +1,58 @@
+#define SCRY_PROFILE
+#include "scry.hpp"
+
+#include <cassert>
+#include <cstddef>
+
+constexpr static const char profiled_pattern[] = R"(ab*c)";
+
+bool match_elsewhere(const char *str);
+
+/**
+ * Counters recorded for `op` in `stats`, which are zero if it never executed
+ */
+template <typename op>
+scry::profile::counters counters_of(const scry::profile::stats &stats) {
+  for (std::size_t i = 0; i < stats.size; ++i) {
+    if (stats.entries[i].id == &scry::profile::tag<op>::id) {
+      return stats.entries[i].count;
+    }
+  }
+  return {};
+}
+
+int main() {
+
+  // Test counting executions and probes of each op
+  using profiled = scry::regex<profiled_pattern>;
+  using accept_b = scry::op::accept<'b'>;
+  using accept_c = scry::op::accept_sequence<scry::op::accept<'c'>>;
+  using star_b = scry::op::accept_zero_or_more<accept_b, accept_c>;
+  static_assert(scry::regex_match<profiled>("abbc"));
+  scry::profile::stats stats;
+  {
+    scry::profile::scope scope{stats};
+    assert(scry::regex_match<profiled>("abbc"));
+  }
+  assert(counters_of<accept_b>(stats).executions == 2);
+  assert(counters_of<accept_b>(stats).consumed == 2);
+  assert(counters_of<accept_c>(stats).executions == 1);
+  assert(counters_of<star_b>(stats).executions == 1);
+  assert(counters_of<star_b>(stats).consumed == 3);
+  assert(counters_of<star_b>(stats).probes == 1);
+  assert(counters_of<star_b>(stats).backtracks == 0);
+  assert(counters_of<scry::op::accept<'x'>>(stats).executions == 0);
+
+  // Test that nothing is recorded outside of a scope
+  assert(scry::regex_match<profiled>("abbc"));
+  assert(counters_of<star_b>(stats).executions == 1);
+
+  // Test merging executions in other translation units into the same ops
+  {
+    scry::profile::scope scope{stats};
+    assert(match_elsewhere("abc"));
+  }
+  assert(counters_of<star_b>(stats).executions == 2);
+  assert(counters_of<star_b>(stats).consumed == 5);
+  assert(counters_of<accept_b>(stats).executions == 3);
+}
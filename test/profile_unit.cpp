@@ -0,0 +1,12 @@
+#define SCRY_PROFILE
+#include "scry.hpp"
+
+constexpr static const char profiled_pattern[] = R"(ab*c)";
+
+/**
+ * Matches the pattern of profile.cpp in another translation unit, whose
+ * executions must be recorded under the same ops
+ */
+bool match_elsewhere(const char *str) {
+  return scry::regex_match<scry::regex<profiled_pattern>>(str);
+}
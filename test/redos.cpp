@@ -0,0 +1,119 @@
+#define SCRY_PROFILE
+#include "scry.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+constexpr static const char adjacent_stars_pattern[] = R"(a*a*a*b)";
+constexpr static const char adjacent_dots_pattern[] = R"(.*.*.*x)";
+constexpr static const char overlapping_classes_pattern[] =
+    R"([[:alpha:]]*[[:alnum:]]*[a-z]*!)";
+constexpr static const char large_exact_pattern[] = R"(a\{1000\}b)";
+constexpr static const char large_bounded_pattern[] =
+    R"(a\{1,1000\}a\{1,1000\}b)";
+constexpr static const char large_least_pattern[] = R"(a\{500,\}a*b)";
+constexpr static const char star_then_bounded_pattern[] = R"(a*a\{1,50\}b)";
+constexpr static const char repeated_dot_pattern[] = R"(x.\{200\}y)";
+
+namespace {
+
+/**
+ * Adversarial pattern and input, with the most steps (ops executed and
+ * quantifier probes, see profile.hpp) and milliseconds a single execution
+ * may take. No input matches its pattern. Step budgets are deterministic and
+ * catch regressions in optimise.hpp and codegen.hpp, whereas time budgets are
+ * deliberately loose and only catch regressions too large to have been
+ * counted.
+ */
+struct redos_case {
+  const char *name;
+  bool (*run)(const std::string &);
+  std::string input;
+  std::uint64_t step_budget;
+  double time_budget;
+};
+
+template <typename regex> bool match(const std::string &input) {
+  return scry::regex_match<regex>(input);
+}
+
+template <typename regex> bool search(const std::string &input) {
+  return static_cast<bool>(scry::regex_search<regex>(input));
+}
+
+std::uint64_t steps_of(const scry::profile::stats &stats) {
+  std::uint64_t result = stats.overflow.executions + stats.overflow.probes;
+  for (std::size_t i = 0; i < stats.size; ++i) {
+    const scry::profile::counters &count = stats.entries[i].count;
+    result += count.executions + count.probes;
+  }
+  return result;
+}
+
+std::string repeat(char c, std::size_t n) { return std::string(n, c); }
+
+} // anonymous namespace
+
+/**
+ * Runs each adversarial case once, failing if any case exceeds its step or
+ * time budget
+ */
+int main() {
+  using adjacent_stars = scry::regex<adjacent_stars_pattern>;
+  using adjacent_dots = scry::regex<adjacent_dots_pattern>;
+  using overlapping_classes = scry::regex<overlapping_classes_pattern>;
+  using large_exact = scry::regex<large_exact_pattern>;
+  using large_bounded = scry::regex<large_bounded_pattern>;
+  using large_least = scry::regex<large_least_pattern>;
+  using star_then_bounded = scry::regex<star_then_bounded_pattern>;
+  using repeated_dot = scry::regex<repeated_dot_pattern>;
+
+  const redos_case cases[] = {
+      {"a*a*a*b match", match<adjacent_stars>, repeat('a', 5000), 10, 100},
+      {"a*a*a*b search", search<adjacent_stars>, repeat('a', 100), 10000,
+       100},
+      {".*.*.*x match", match<adjacent_dots>, repeat('a', 100), 10, 100},
+      {".*.*.*x search", search<adjacent_dots>, repeat('a', 50), 250, 100},
+      {"classes match", match<overlapping_classes>, repeat('a', 100), 750000,
+       100},
+      {"a{1000}b match", match<large_exact>, repeat('a', 5000), 2000, 100},
+      {"a{1000}b search", search<large_exact>, repeat('a', 5000), 9000000,
+       1000},
+      {"a{1,1000}a{1,1000}b match", match<large_bounded>, repeat('a', 2000),
+       4000, 100},
+      {"a{500,}a*b match", match<large_least>, repeat('a', 2000), 10, 100},
+      {"a*a{1,50}b match", match<star_then_bounded>, repeat('a', 2000), 10,
+       100},
+      {"a*a{1,50}b search", search<star_then_bounded>, repeat('a', 200),
+       41000, 100},
+      {"x.{200}y search", search<repeated_dot>, repeat('x', 5000), 2000000,
+       500},
+  };
+
+  int failures = 0;
+  for (const redos_case &c : cases) {
+    scry::profile::stats stats;
+    const auto start = std::chrono::steady_clock::now();
+    bool matched = false;
+    {
+      scry::profile::scope scope{stats};
+      matched = c.run(c.input);
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double time =
+        std::chrono::duration<double, std::milli>(stop - start).count();
+    const std::uint64_t steps = steps_of(stats);
+    const bool failed =
+        matched || steps > c.step_budget || time > c.time_budget;
+    failures += failed;
+    std::printf("%-28s %12llu / %-12llu steps %9.2f / %-7.0f ms%s\n", c.name,
+                static_cast<unsigned long long>(steps),
+                static_cast<unsigned long long>(c.step_budget), time,
+                c.time_budget, failed ? "  FAILED" : "");
+  }
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,7 +1,17 @@
+#include "explain.hpp"
 #include "scry.hpp"
 
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <forward_list>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 constexpr static const char abcdef_pattern[] = R"(abcdef)";
 constexpr static const char a____f_pattern[] = R"(a....f)";
@@ -28,6 +38,105 @@ constexpr static const char cntrl_cc_pattern[] = R"([[:cntrl:]]*)";
 constexpr static const char graph_cc_pattern[] = R"([[:graph:]]*)";
 constexpr static const char print_cc_pattern[] = R"([[:print:]]*)";
 constexpr static const char word_cc_pattern[] = R"([[:word:]]*)";
+constexpr static const char field_pattern[] = R"([^,]*,)";
+constexpr static const char fields_pattern[] = R"([^,]*,[^,]*,[^,]*)";
+constexpr static const char key_value_pattern[] = R"([[:alpha:]]*=.*)";
+constexpr static const char last_x_pattern[] = R"(.*x)";
+constexpr static const char last_x_suffix_pattern[] = R"(.*x[[:digit:]])";
+constexpr static const char a_then_20_pattern[] = R"(.*a.\{20\})";
+constexpr static const char star_pairs_pattern[] = R"(b*[ab]\{2\}*)";
+constexpr static const char x_pairs_x_pattern[] = R"(x*[ax]\{2\}*x)";
+constexpr static const char keyword_pattern[] = R"(if)";
+constexpr static const char identifier_pattern[] = R"([[:alpha:]][[:alnum:]]*)";
+constexpr static const char number_pattern[] = R"([[:digit:]]\{1,\})";
+constexpr static const char whitespace_pattern[] = R"([[:space:]]\{1,\})";
+constexpr static const char assign_pattern[] = R"(=)";
+constexpr static const char equals_pattern[] = R"(==)";
+constexpr static const char id_pattern[] = R"([[:digit:]]\{4,\})";
+constexpr static const char email_pattern[] =
+    R"([[:alnum:]._]\{1,\}@[[:alnum:].]\{1,\})";
+constexpr static const char maybe_x_pattern[] = R"(x*)";
+constexpr static const char log_file_pattern[] =
+    R"(.*[[:digit:]]\{2,\}\.log$)";
+constexpr static const char version_pattern[] =
+    R"([[:alnum:]]*[0-9]\{1,3\}[.-]\{1,2\}[a-c]*z)";
+constexpr static const char trailing_number_pattern[] =
+    R"([[:digit:]]\{1,\}$)";
+constexpr static const char comma_pattern[] = R"([[:space:]]*,[[:space:]]*)";
+constexpr static const char utf8_dot_pattern[] = R"(a.c)";
+constexpr static const char utf8_run_pattern[] = R"(é*)";
+constexpr static const char utf8_range_pattern[] = R"([à-ÿ]*)";
+constexpr static const char utf8_not_a_pattern[] = R"([^a]\{3\})";
+constexpr static const char utf8_mixed_pattern[] = R"([aé€]*)";
+constexpr static const char utf8_field_pattern[] = R"(.*,)";
+constexpr static const char utf8_accent_suffix_pattern[] = R"(.*é)";
+constexpr static const char high_bytes_pattern[] = "[ -\xff]*";
+constexpr static const char nested_stars_pattern[] = R"(a**)";
+constexpr static const char repeated_exact_pattern[] = R"(a\{2\}\{3\})";
+constexpr static const char even_as_pattern[] = R"(a\{2\}*)";
+constexpr static const char merged_repeats_pattern[] = R"(a\{2\}a\{3,\}x)";
+constexpr static const char ranged_star_pattern[] = R"(a\{1,2\}*)";
+constexpr static const char repeated_range_pattern[] = R"(a\{2,3\}\{2\})";
+constexpr static const char ranged_range_pattern[] = R"(a\{2,3\}\{1,2\})";
+constexpr static const char ranged_range_suffix_pattern[] =
+    R"(x*a\{2,3\}\{1,2\}b)";
+constexpr static const char nested_bounds_pattern[] =
+    R"(a*\{2\}b\{1,2\}\{2\})";
+constexpr static const char get_word[] = "GET";
+constexpr static const char post_word[] = "POST";
+constexpr static const char put_word[] = "PUT";
+constexpr static const char patch_word[] = "PATCH";
+constexpr static const char he_word[] = "he";
+constexpr static const char she_word[] = "she";
+constexpr static const char his_word[] = "his";
+constexpr static const char hers_word[] = "hers";
+constexpr static const char redacted_format[] = "<redacted>";
+constexpr static const char bracketed_format[] = "[$&]";
+constexpr static const char dollar_format[] = "$$$&$$";
+constexpr static const char dash_format[] = "-";
+
+SCRY_DECLARE_REGEX(precompiled_email);
+SCRY_DEFINE_REGEX(precompiled_email, scry::regex<email_pattern>);
+
+namespace formats {
+using namespace scry::literals;
+SCRY_DECLARE_REGEX(precompiled_fields);
+SCRY_DEFINE_REGEX(precompiled_fields, decltype(R"([^,]*,[^,]*,)"_re));
+} // namespace formats
+
+/**
+ * Determines whether a regex compiled at runtime from the same pattern as
+ * `regex` agrees with it on `str`
+ */
+template <typename regex> bool dynamic_agrees(const char *str) {
+  std::string pattern;
+  for (std::size_t i = 0; i < regex::string::size; ++i) {
+    pattern += regex::string::get(i);
+  }
+  auto dynamic = scry::dynamic_regex::compile(pattern);
+  return dynamic &&
+         scry::regex_match(*dynamic, str) == scry::regex_match<regex>(str);
+}
+
+/**
+ * Determines whether a lazy DFA of `regex` agrees with its backtracking
+ * program on `str`
+ */
+template <typename regex, std::size_t capacity = 256>
+bool lazy_agrees(const char *str) {
+  scry::lazy_dfa<regex, capacity> dfa;
+  return dfa.match(str, str + std::strlen(str)) ==
+         scry::regex_match<regex>(str);
+}
+
+/**
+ * Determines whether the bit-parallel engine for `regex` agrees with its
+ * backtracking program on `str`
+ */
+template <typename regex> bool bit_parallel_agrees(const char *str) {
+  return scry::bit_parallel<regex>::match(str, str + std::strlen(str)) ==
+         scry::regex_match<regex>(str);
+}
 
 int main() {
 
@@ -56,6 +165,12 @@ int main() {
   using graph_cc = scry::regex<graph_cc_pattern>;
   using print_cc = scry::regex<print_cc_pattern>;
   using word_cc = scry::regex<word_cc_pattern>;
+  using field = scry::regex<field_pattern>;
+  using fields = scry::regex<fields_pattern>;
+  using key_value = scry::regex<key_value_pattern>;
+  using last_x = scry::regex<last_x_pattern>;
+  using last_x_suffix = scry::regex<last_x_suffix_pattern>;
+  using a_then_20 = scry::regex<a_then_20_pattern>;
 
   // Test char seqeuences
   assert(scry::regex_match<abcdef>("abcdef"));
@@ -253,4 +368,681 @@ int main() {
   assert(!scry::regex_match<word_cc>("\t"));
   assert(!scry::regex_match<word_cc>("\f"));
   assert(!scry::regex_match<word_cc>("\v"));
+
+  // Test quantified classes terminated by a symbol
+  assert(scry::regex_match<field>("abc,"));
+  assert(scry::regex_match<field>(","));
+  assert(!scry::regex_match<field>(""));
+  assert(!scry::regex_match<field>("abc"));
+  assert(!scry::regex_match<field>("ab,c"));
+  assert(!scry::regex_match<field>("ab,,"));
+  assert(scry::regex_match<fields>("a,b,c"));
+  assert(scry::regex_match<fields>(",,"));
+  assert(!scry::regex_match<fields>("a,b"));
+  assert(!scry::regex_match<fields>("a,b,c,"));
+  assert(scry::regex_match<key_value>("key=value"));
+  assert(scry::regex_match<key_value>("key=a=b"));
+  assert(scry::regex_match<key_value>("="));
+  assert(!scry::regex_match<key_value>("key"));
+  assert(!scry::regex_match<key_value>("k3y=value"));
+
+  // Test "." terminated by a symbol
+  assert(scry::regex_match<last_x>("x"));
+  assert(scry::regex_match<last_x>("abx"));
+  assert(scry::regex_match<last_x>("xaxbx"));
+  assert(!scry::regex_match<last_x>(""));
+  assert(!scry::regex_match<last_x>("xa"));
+  assert(scry::regex_match<last_x_suffix>("x1"));
+  assert(scry::regex_match<last_x_suffix>("x1x2"));
+  assert(scry::regex_match<last_x_suffix>("x1xax3"));
+  assert(!scry::regex_match<last_x_suffix>("x1xa"));
+  assert(!scry::regex_match<last_x_suffix>("xx"));
+
+  // Test rendering of compilation stages
+  constexpr auto field_program = scry::explain::program<field>();
+  assert(std::strcmp(field_program.c_str(),
+                     "accept_sequence\n"
+                     "  accept_until first ',' (memchr)  [O(n)]\n"
+                     "    next: accept_sequence\n") == 0);
+  using last_x_stages = scry::explain::stages<last_x_suffix>;
+  static_assert(last_x_stages::reversed);
+  static_assert(
+      std::is_same<typename last_x_stages::code,
+                   typename scry::reverse_result<last_x_suffix>::code>::value);
+  assert(std::strstr(scry::explain::plan<last_x_suffix>().c_str(),
+                     "\ncodegen (reversed):\n"));
+  static_assert(!scry::explain::stages<field>::reversed);
+  assert(std::strstr(scry::explain::plan<field>().c_str(), "\ncodegen:\n"));
+  constexpr auto between_as_tree = scry::explain::optimised_tree<between_as>();
+  assert(std::strcmp(between_as_tree.c_str(), "sequence\n"
+                                              "  exactly 5\n"
+                                              "    symbol 'a'\n"
+                                              "  at_most 5\n"
+                                              "    symbol 'a'\n") == 0);
+
+  // Test normalising nested and adjacent quantifiers
+  using nested_stars = scry::regex<nested_stars_pattern>;
+  using repeated_exact = scry::regex<repeated_exact_pattern>;
+  using even_as = scry::regex<even_as_pattern>;
+  using merged_repeats = scry::regex<merged_repeats_pattern>;
+  using nested_bounds = scry::regex<nested_bounds_pattern>;
+  using repeated_range = scry::regex<repeated_range_pattern>;
+  using ranged_range = scry::regex<ranged_range_pattern>;
+  using ranged_star = scry::regex<ranged_star_pattern>;
+  static_assert(scry::regex_match<nested_stars>(""));
+  static_assert(scry::regex_match<nested_stars>("aaa"));
+  static_assert(!scry::regex_match<nested_stars>("aab"));
+  static_assert(scry::regex_match<repeated_exact>("aaaaaa"));
+  static_assert(!scry::regex_match<repeated_exact>("aaaaa"));
+  static_assert(scry::regex_match<even_as>("aaaa"));
+  static_assert(!scry::regex_match<even_as>("aaa"));
+  static_assert(!scry::regex_match<merged_repeats>("aaaax"));
+  static_assert(scry::regex_match<merged_repeats>("aaaaax"));
+  static_assert(scry::regex_match<merged_repeats>("aaaaaaaax"));
+  static_assert(scry::regex_match<nested_bounds>("aabb"));
+  static_assert(scry::regex_match<nested_bounds>("bbbb"));
+  static_assert(!scry::regex_match<nested_bounds>("abbbbb"));
+  static_assert(!scry::regex_match<nested_bounds>("ab"));
+  static_assert(scry::regex_match<repeated_range>("aaaaa"));
+  static_assert(!scry::regex_match<repeated_range>("aaa"));
+  static_assert(!scry::regex_match<repeated_range>("aaaaaaa"));
+  static_assert(scry::regex_match<ranged_range>("aa"));
+  static_assert(scry::regex_match<ranged_range>("aaaaaa"));
+  static_assert(!scry::regex_match<ranged_range>("a"));
+  static_assert(!scry::regex_match<ranged_range>("aaaaaaa"));
+  static_assert(scry::regex_match<ranged_star>("aaa"));
+  static_assert(!scry::regex_match<ranged_star>("aab"));
+  constexpr auto nested_stars_tree =
+      scry::explain::optimised_tree<nested_stars>();
+  assert(std::strcmp(nested_stars_tree.c_str(), "sequence\n"
+                                                "  zero_or_more\n"
+                                                "    symbol 'a'\n") == 0);
+  constexpr auto repeated_exact_tree =
+      scry::explain::optimised_tree<repeated_exact>();
+  assert(std::strcmp(repeated_exact_tree.c_str(), "sequence\n"
+                                                  "  exactly 6\n"
+                                                  "    symbol 'a'\n") == 0);
+  constexpr auto repeated_range_tree =
+      scry::explain::optimised_tree<repeated_range>();
+  assert(std::strcmp(repeated_range_tree.c_str(), "sequence\n"
+                                                  "  exactly 4\n"
+                                                  "    symbol 'a'\n"
+                                                  "  at_most 2\n"
+                                                  "    symbol 'a'\n") == 0);
+  constexpr auto ranged_range_tree =
+      scry::explain::optimised_tree<ranged_range>();
+  assert(std::strcmp(ranged_range_tree.c_str(), "sequence\n"
+                                                "  exactly 2\n"
+                                                "    symbol 'a'\n"
+                                                "  at_most 4\n"
+                                                "    symbol 'a'\n") == 0);
+  constexpr auto adjacent_stars_tree = scry::explain::optimised_tree<
+      decltype(scry::literals::operator""_re<char, 'a', '*', 'a', '*'>())>();
+  assert(std::strcmp(adjacent_stars_tree.c_str(), "sequence\n"
+                                                  "  zero_or_more\n"
+                                                  "    symbol 'a'\n") == 0);
+  using after_anchor = scry::optimise_result<scry::ast::sequence<
+      scry::ast::symbol<'a'>, scry::ast::right_anchor,
+      scry::ast::zero_or_more<scry::ast::symbol<'b'>>, scry::ast::right_anchor,
+      scry::ast::symbol<'c'>>>::type;
+  static_assert(std::is_same<after_anchor,
+                             scry::ast::sequence<scry::ast::never>>::value);
+  using until_anchor = scry::optimise_result<scry::ast::sequence<
+      scry::ast::symbol<'a'>, scry::ast::right_anchor,
+      scry::ast::zero_or_more<scry::ast::symbol<'b'>>>>::type;
+  static_assert(
+      std::is_same<until_anchor,
+                   scry::ast::sequence<scry::ast::symbol<'a'>,
+                                       scry::ast::right_anchor>>::value);
+  using never_code = scry::codegen_result<after_anchor>::type;
+  const char *never_input = "ac";
+  assert(!scry::op::dispatch<never_code>(never_input, never_input + 2));
+  for (const char *str : {"", "a", "aa", "aaaa", "aaaaax", "aabb", "bbb"}) {
+    assert((lazy_agrees<even_as>(str)));
+    assert((bit_parallel_agrees<nested_bounds>(str)));
+  }
+
+  // Test runtime-compiled patterns against their compile-time counterparts
+  using star_pairs = scry::regex<star_pairs_pattern>;
+  using x_pairs_x = scry::regex<x_pairs_x_pattern>;
+  static_assert(scry::regex_match<star_pairs>("ba"));
+  static_assert(scry::regex_match<star_pairs>("bba"));
+  static_assert(!scry::regex_match<star_pairs>("aaa"));
+  for (const char *str :
+       {"", "a", "aaaaaaaaaa", "abcdef", "a....f", "^^$$", "aaaaaaa", "fedcba",
+        "xyz", "ABC", "0123", " \t", "a,b,c", "key=value", "x1xax3", "xaxbx",
+        "!?~#", "ba", "bba", "baaa", "baab", "xaaxx", "xaxxx", "aa", "aaaaa",
+        "aaaaaa", "aaaaax", "aabb", "bbbb", "abbbbb"}) {
+    assert(dynamic_agrees<abcdef>(str));
+    assert(dynamic_agrees<a____f>(str));
+    assert(dynamic_agrees<adotsf>(str));
+    assert(dynamic_agrees<lotofa>(str));
+    assert(dynamic_agrees<anchored_abcdef>(str));
+    assert(dynamic_agrees<escaped_anchor>(str));
+    assert(dynamic_agrees<ten_as>(str));
+    assert(dynamic_agrees<least_ten_as>(str));
+    assert(dynamic_agrees<between_as>(str));
+    assert(dynamic_agrees<some_abcdef>(str));
+    assert(dynamic_agrees<some_lower>(str));
+    assert(dynamic_agrees<not_some_lower>(str));
+    assert(dynamic_agrees<alpha_cc>(str));
+    assert(dynamic_agrees<xdigit_cc>(str));
+    assert(dynamic_agrees<punct_cc>(str));
+    assert(dynamic_agrees<space_cc>(str));
+    assert(dynamic_agrees<graph_cc>(str));
+    assert(dynamic_agrees<word_cc>(str));
+    assert(dynamic_agrees<field>(str));
+    assert(dynamic_agrees<fields>(str));
+    assert(dynamic_agrees<key_value>(str));
+    assert(dynamic_agrees<last_x>(str));
+    assert(dynamic_agrees<last_x_suffix>(str));
+    assert(dynamic_agrees<star_pairs>(str));
+    assert(dynamic_agrees<x_pairs_x>(str));
+    assert(dynamic_agrees<nested_stars>(str));
+    assert(dynamic_agrees<ranged_star>(str));
+    assert(dynamic_agrees<repeated_exact>(str));
+    assert(dynamic_agrees<even_as>(str));
+    assert(dynamic_agrees<merged_repeats>(str));
+    assert(dynamic_agrees<nested_bounds>(str));
+    assert(dynamic_agrees<repeated_range>(str));
+    assert(dynamic_agrees<ranged_range>(str));
+  }
+  assert(!scry::dynamic_regex::compile(R"(a\q)"));
+  assert(!scry::dynamic_regex::compile(R"([abc)"));
+  assert(!scry::dynamic_regex::compile(R"(\{2\})"));
+  assert(!scry::dynamic_regex::compile(R"(a\{5,2\})"));
+  assert(!scry::dynamic_regex::compile(R"(a\{02\})"));
+  assert(!scry::dynamic_regex::compile(R"(a\{2,3\}*)"));
+  assert(!scry::dynamic_regex::compile(R"([[.ab.]])"));
+  assert(!scry::dynamic_regex::compile("a", scry::trait::basic |
+                                                scry::trait::extended));
+
+  // Test lazy DFAs against the backtracking programs
+  for (const char *str :
+       {"", "a", "aaaaaaaaaa", "abcdef", "^^$$", "aaaaaaa", "xyz", "a,b,c",
+        "key=value", "x1xax3", "xaxbx", "a01234567890123456789",
+        "ba0123456789012345678", "xxa01234567890123456789xx",
+        "xxa0123456789012345678a0123456789012345678",
+        "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"}) {
+    assert(lazy_agrees<abcdef>(str));
+    assert(lazy_agrees<lotofa>(str));
+    assert(lazy_agrees<anchored_abcdef>(str));
+    assert(lazy_agrees<escaped_anchor>(str));
+    assert(lazy_agrees<ten_as>(str));
+    assert(lazy_agrees<least_ten_as>(str));
+    assert(lazy_agrees<between_as>(str));
+    assert(lazy_agrees<some_lower>(str));
+    assert(lazy_agrees<fields>(str));
+    assert(lazy_agrees<key_value>(str));
+    assert(lazy_agrees<last_x>(str));
+    assert(lazy_agrees<last_x_suffix>(str));
+    assert(lazy_agrees<a_then_20>(str));
+    assert((lazy_agrees<a_then_20, 3>(str)));
+  }
+  scry::lazy_dfa<a_then_20, 8> small;
+  assert(!small.match("xxa01234567890123456789xxxxxxxxxxxxxxxxxxxx",
+                     "xxa01234567890123456789xxxxxxxxxxxxxxxxxxxx" + 43));
+  assert(small.flushes() > 0);
+  assert(small.states() <= 8);
+
+  // Test the bit-parallel engine against the backtracking programs
+  for (const char *str :
+       {"", "a", "aaaaaaaaaa", "abcdef", "^^$$", "aaaaaaa", "xyz", "a,b,c",
+        "key=value", "x1xax3", "xaxbx", "a01234567890123456789",
+        "ba0123456789012345678", "xxa01234567890123456789xx",
+        "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"}) {
+    assert(bit_parallel_agrees<abcdef>(str));
+    assert(bit_parallel_agrees<lotofa>(str));
+    assert(bit_parallel_agrees<anchored_abcdef>(str));
+    assert(bit_parallel_agrees<escaped_anchor>(str));
+    assert(bit_parallel_agrees<ten_as>(str));
+    assert(bit_parallel_agrees<least_ten_as>(str));
+    assert(bit_parallel_agrees<between_as>(str));
+    assert(bit_parallel_agrees<some_lower>(str));
+    assert(bit_parallel_agrees<fields>(str));
+    assert(bit_parallel_agrees<key_value>(str));
+    assert(bit_parallel_agrees<last_x>(str));
+    assert(bit_parallel_agrees<last_x_suffix>(str));
+    assert(bit_parallel_agrees<a_then_20>(str));
+  }
+  constexpr static const char abcdef_text[] = "xxabcdefxx";
+  static_assert(scry::bit_parallel<abcdef>::match(abcdef_text + 2,
+                                                  abcdef_text + 8));
+  static_assert(!scry::bit_parallel<abcdef>::match(abcdef_text,
+                                                   abcdef_text + 10));
+  static_assert(scry::bit_parallel<abcdef>::search(abcdef_text,
+                                                   abcdef_text + 10));
+  static_assert(!scry::bit_parallel<anchored_abcdef>::search(abcdef_text,
+                                                             abcdef_text + 10));
+  assert(scry::bit_parallel<ten_as>::search("xaaaaaaaaaaax",
+                                            "xaaaaaaaaaaax" + 13));
+  assert(!scry::bit_parallel<ten_as>::search("xaaaaaaaaax",
+                                             "xaaaaaaaaax" + 11));
+  assert(scry::bit_parallel<last_x_suffix>::search("abx1cd", "abx1cd" + 6));
+  assert(scry::bit_parallel<lotofa>::search("bbb", "bbb" + 3));
+  assert(scry::bit_parallel<escaped_anchor>::search("^^$$", "^^$$" + 4));
+  assert(!scry::bit_parallel<escaped_anchor>::search("^^$$x", "^^$$x" + 5));
+
+  // Test matching in constant expressions
+  static_assert(scry::regex_match<abcdef>("abcdef"));
+  static_assert(!scry::regex_match<abcdef>("abcde"));
+  static_assert(scry::regex_match<anchored_abcdef>("abcdef"));
+  static_assert(scry::regex_match<between_as>("aaaaaaa"));
+  static_assert(scry::regex_match<some_lower>("scry"));
+  static_assert(scry::regex_match<field>("key,"));
+  static_assert(!scry::regex_match<field>("key,value"));
+  static_assert(scry::regex_match<last_x_suffix>("x1xax3"));
+  static_assert(scry::regex_match<key_value>(std::string_view{"key=value"}));
+
+  // Test matching owned and borrowed strings
+  assert(scry::regex_match<abcdef>(std::string{"abcdef"}));
+  assert(!scry::regex_match<abcdef>(std::string{"abcdefg"}));
+  assert(scry::regex_match<fields>(std::string{"a,b,c"}));
+  assert(scry::regex_match<last_x>(std::string_view{"abxcd"}.substr(0, 3)));
+
+  // Test lexing with longest matches and leftmost-priority ties
+  using keyword = scry::regex<keyword_pattern>;
+  using identifier = scry::regex<identifier_pattern>;
+  using number = scry::regex<number_pattern>;
+  using whitespace = scry::regex<whitespace_pattern>;
+  using assign = scry::regex<assign_pattern>;
+  using equals = scry::regex<equals_pattern>;
+  using tokens = scry::lexer<keyword, identifier, number, whitespace, assign,
+                             equals>;
+  tokens lex;
+  const std::string source = "if iffy == 42 x1=7;";
+  const std::size_t expected[] = {0, 3, 1, 3, 5, 3,
+                                  2, 3, 1, 4, 2, tokens::nomatch};
+  const char *lexemes[] = {"if", " ", "iffy", " ", "==", " ", "42",
+                           " ",  "x1", "=", "7", ";"};
+  std::size_t count = 0;
+  for (const auto &lexeme : lex.tokens(source.begin(), source.end())) {
+    assert(lexeme.id == expected[count]);
+    assert(std::string(lexeme.begin, lexeme.end) == lexemes[count]);
+    ++count;
+  }
+  assert(count == 12);
+  assert(lex.tokens(source.end(), source.end()).begin() ==
+         lex.tokens(source.end(), source.end()).end());
+
+  // Test searching for the leftmost match
+  using id = scry::regex<id_pattern>;
+  using email = scry::regex<email_pattern>;
+  using maybe_x = scry::regex<maybe_x_pattern>;
+  constexpr auto found_id = scry::regex_search<id>("user 12 id 123456 ok");
+  static_assert(found_id && found_id.length() == 6);
+  const std::string_view log = "user 12 id 123456 ok";
+  auto found = scry::regex_search<id>(log);
+  assert(found && found.begin == log.data() + 11 && found.length() == 6);
+  assert(!scry::regex_search<id>("user 12 id 123 ok"));
+  assert(scry::regex_search<anchored_abcdef>("abcdef"));
+  assert(!scry::regex_search<anchored_abcdef>("xabcdef"));
+  assert(scry::regex_search<last_x_suffix>("abx1x2cd").length() == 6);
+  assert(scry::regex_search<maybe_x>("abc").length() == 0);
+
+  // Test quantifiers whose continuation reaches the end after an earlier
+  // repetition than the last it accepts after
+  const std::forward_list<char> x_pairs_input = {'x', 'a', 'a', 'x', 'x'};
+  assert(scry::regex_match<x_pairs_x>(x_pairs_input.begin(),
+                                      x_pairs_input.end()));
+  static_assert(scry::regex_match<x_pairs_x>("xaaxx"));
+  static_assert(scry::regex_search<star_pairs>("bba").length() == 3);
+  const std::forward_list<char> x_pairs_odd = {'x', 'a', 'a', 'x'};
+  assert(scry::regex_match<x_pairs_x>(x_pairs_odd.begin(), x_pairs_odd.end()));
+  const std::forward_list<char> x_pairs_none = {'x', 'a', 'x', 'a'};
+  assert(!scry::regex_match<x_pairs_x>(x_pairs_none.begin(),
+                                       x_pairs_none.end()));
+
+  // Test quantifiers which only probe where their continuation may start
+  using version = scry::regex<version_pattern>;
+  for (const char *str : {"", "z", "1z", "v12z", "v1234-z", "v12.z", "v12-abz",
+                          "v12..z", "v1...z", "a1b2.-cz", "12z3z", "99.cz",
+                          "9.c"}) {
+    assert(dynamic_agrees<version>(str));
+  }
+  assert(scry::regex_match<version>(u"v12-abz"));
+  assert(!scry::regex_match<version>(u"v12-ab\u017a"));
+
+  // Test matching batches of records in parallel
+  std::vector<std::string> batch_storage;
+  for (std::size_t i = 0; i < 3 * scry::parallel_chunk_size + 100; ++i) {
+    batch_storage.push_back(i % 3 == 0 ? "k" + std::to_string(i) + ","
+                                       : std::to_string(i) + "=v");
+  }
+  std::vector<std::string_view> batch(batch_storage.begin(),
+                                      batch_storage.end());
+  for (std::size_t threads : {1, 4}) {
+    scry::thread_pool pool{threads};
+    assert(pool.size() == threads);
+    std::vector<std::uint64_t> bitmap(
+        scry::parallel_result_words(batch.size()), ~std::uint64_t{0});
+    scry::regex_match_parallel<field>(batch, bitmap.data(), pool);
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      assert(((bitmap[i / 64] >> (i % 64)) & 1) == (i % 3 == 0));
+    }
+    assert(bitmap.back() >> (batch.size() % 64) == 0);
+    scry::regex_match_parallel<field>(batch.data(), 10, bitmap.data(), pool);
+    assert(bitmap[0] == 0b1001001001);
+    scry::regex_match_parallel<field>(batch.data(), 0, bitmap.data(), pool);
+    assert(bitmap[0] == 0b1001001001);
+  }
+
+  // Test filtering columns of strings laid out as offsets into one buffer
+  std::string column_data;
+  std::vector<std::int32_t> offsets32{0};
+  std::vector<std::int64_t> offsets64{0};
+  for (std::size_t i = 0; i < 150; ++i) {
+    column_data += i % 5 == 0 ? "a,b,c" : i % 5 == 1 ? "" : "a,b";
+    offsets32.push_back(static_cast<std::int32_t>(column_data.size()));
+    offsets64.push_back(static_cast<std::int64_t>(column_data.size()));
+  }
+  std::uint64_t selection[3] = {~std::uint64_t{0}, ~std::uint64_t{0},
+                                ~std::uint64_t{0}};
+  scry::filter_column<fields>(column_data.data(), offsets32.data(), 150,
+                              selection);
+  for (std::size_t i = 0; i < 150; ++i) {
+    assert(((selection[i / 64] >> (i % 64)) & 1) == (i % 5 == 0));
+  }
+  assert(selection[2] >> (150 - 128) == 0);
+  scry::filter_column<lotofa>(column_data.data(), offsets64.data() + 1, 3,
+                              selection);
+  assert(selection[0] == 0b001);
+
+  // Test matching suffixes in reverse and searching for the last match
+  using log_file = scry::regex<log_file_pattern>;
+  using trailing_number = scry::regex<trailing_number_pattern>;
+  static_assert(scry::regex_match<log_file>("/var/log/app-20.log"));
+  static_assert(!scry::regex_match<log_file>("/var/log/app-2.log"));
+  for (const char *str : {"", "1.log", "12.log", "a/12.log", "12.logx",
+                          "12.log.12.log", "12x.log", "123456.log", ".log"}) {
+    assert(dynamic_agrees<log_file>(str));
+  }
+  assert(scry::regex_match<log_file>(std::string{"x99.log"}));
+  assert(!scry::regex_match<log_file>(std::string{"x99.lag"}));
+  constexpr auto last_id = scry::regex_rsearch<id>("user 12 id 123456 ok");
+  static_assert(last_id && last_id.length() == 6);
+  const std::string_view ids_log = "id 1234 id 56789 id 12";
+  auto last = scry::regex_rsearch<id>(ids_log);
+  assert(last && last.begin == ids_log.data() + 11 && last.length() == 5);
+  assert(!scry::regex_rsearch<id>("user 12 id 123 ok"));
+  assert(scry::regex_rsearch<trailing_number>("a 12 b 345").length() == 3);
+  assert(!scry::regex_rsearch<trailing_number>("a 12 b"));
+  assert(scry::regex_rsearch<anchored_abcdef>("abcdef"));
+  assert(!scry::regex_rsearch<anchored_abcdef>("abcdefx"));
+  assert(!scry::regex_rsearch<anchored_abcdef>("xabcdef"));
+  auto last_field = scry::regex_rsearch<field>("a,bc,d");
+  assert(std::string_view(last_field.begin, last_field.length()) == "bc,");
+  auto no_x = scry::regex_rsearch<maybe_x>("abc");
+  assert(no_x && no_x.length() == 0 && *no_x.begin == '\0');
+  using ranged_range_suffix = scry::regex<ranged_range_suffix_pattern>;
+  static_assert(scry::regex_match<ranged_range_suffix>("xxaaaab"));
+  static_assert(scry::regex_match<ranged_range_suffix>("aab"));
+  static_assert(!scry::regex_match<ranged_range_suffix>("xab"));
+  static_assert(!scry::regex_match<ranged_range_suffix>("xaaaaaaab"));
+  assert(scry::regex_match<ranged_range_suffix>(std::string{"xaaaaaab"}));
+  assert(!scry::regex_match<ranged_range_suffix>(std::string{"xaaaaaaab"}));
+  using ranged_range_last = scry::regex<ranged_range_pattern>;
+  const std::string_view as_log = "aaaaaaa b aaa";
+  auto last_as = scry::regex_rsearch<ranged_range_last>(as_log);
+  assert(last_as && last_as.begin == as_log.data() + 10 &&
+         last_as.length() == 3);
+  assert(!scry::regex_rsearch<ranged_range_last>("a b a"));
+  const std::string mail = "from a.b@c.org to x_y@z.net id 98765";
+  auto last_email = scry::regex_rsearch<email>(mail.begin(), mail.end());
+  assert(std::string(last_email.begin, last_email.end) == "x_y@z.net");
+
+  // Test replacing matches
+  std::string replaced;
+  scry::regex_replace<email, redacted_format>(
+      log.begin(), log.end(), std::back_inserter(replaced));
+  assert(replaced == log);
+  const std::string line = "from a.b@c.org to x_y@z.net id 98765";
+  replaced.clear();
+  scry::regex_replace<email, redacted_format>(line.begin(), line.end(),
+                                              std::back_inserter(replaced));
+  assert(replaced == "from <redacted> to <redacted> id 98765");
+  replaced.clear();
+  scry::regex_replace<id, bracketed_format>(line.begin(), line.end(),
+                                            std::back_inserter(replaced));
+  assert(replaced == "from a.b@c.org to x_y@z.net id [98765]");
+  replaced.clear();
+  scry::regex_replace<id, dollar_format>(line.begin(), line.end(),
+                                         std::back_inserter(replaced));
+  assert(replaced == "from a.b@c.org to x_y@z.net id $98765$");
+  replaced.clear();
+  scry::regex_replace<maybe_x, dash_format>(std::string_view{"axxb"}.begin(),
+                                            std::string_view{"axxb"}.end(),
+                                            std::back_inserter(replaced));
+  assert(replaced == "-a--b-");
+  char buffer[16];
+  assert((scry::regex_replace<id, bracketed_format>("id 1234", buffer, 16) ==
+          9));
+  assert(std::string_view(buffer, 9) == "id [1234]");
+  assert((scry::regex_replace<email, redacted_format>(line, buffer, 16) ==
+          38));
+  assert(std::string_view(buffer, 16) == "from <redacted> ");
+
+  // Test finding every match lazily
+  const char *ids[] = {"1234", "98765", "4321"};
+  std::size_t matches = 0;
+  const std::string_view ids_text = "1234 12 98765 x4321";
+  for (const auto &match : scry::regex_find_all<id>(ids_text)) {
+    assert(std::string_view(match.begin, match.length()) == ids[matches]);
+    ++matches;
+  }
+  assert(matches == 3);
+  matches = 0;
+  for (const auto &match : scry::regex_find_all<maybe_x>("axxb")) {
+    assert(match.length() == (matches == 1 ? 2 : 0));
+    ++matches;
+  }
+  assert(matches == 4);
+  auto anchored = scry::regex_find_all<anchored_abcdef>("abcdef");
+  assert(std::distance(anchored.begin(), anchored.end()) == 1);
+  assert(scry::regex_find_all<id>("no ids").begin() ==
+         scry::regex_find_all<id>("no ids").end());
+
+  // Test splitting into views of the input
+  using comma = scry::regex<comma_pattern>;
+  std::vector<std::string_view> pieces;
+  scry::regex_split<comma>("a , bb,c  ,, d", std::back_inserter(pieces));
+  assert((pieces == std::vector<std::string_view>{"a", "bb", "c", "", "d"}));
+  pieces.clear();
+  scry::regex_split<comma>("a b,", std::back_inserter(pieces));
+  assert((pieces == std::vector<std::string_view>{"a b", ""}));
+  pieces.clear();
+  scry::regex_split<comma>("", std::back_inserter(pieces));
+  assert((pieces == std::vector<std::string_view>{""}));
+  pieces.clear();
+  scry::regex_split<maybe_x>("axxb", std::back_inserter(pieces));
+  assert((pieces == std::vector<std::string_view>{"a", "b"}));
+  std::size_t fields_seen = 0;
+  for (std::string_view piece : scry::regex_split<comma>("1, 2 ,3")) {
+    assert(piece.size() == 1);
+    ++fields_seen;
+  }
+  assert(fields_seen == 3);
+
+  // Test UTF-8 classes, which match whole code points without decoding
+  constexpr scry::trait_type utf8_basic =
+      scry::trait::basic | scry::trait::utf8;
+  using utf8_dot = scry::regex<utf8_dot_pattern, utf8_basic>;
+  using utf8_run = scry::regex<utf8_run_pattern, utf8_basic>;
+  using utf8_range = scry::regex<utf8_range_pattern, utf8_basic>;
+  using utf8_not_a = scry::regex<utf8_not_a_pattern, utf8_basic>;
+  using utf8_mixed = scry::regex<utf8_mixed_pattern, utf8_basic>;
+  using utf8_field = scry::regex<utf8_field_pattern, utf8_basic>;
+  using utf8_abcdef = scry::regex<abcdef_pattern, utf8_basic>;
+  using abcdef_indices = std::make_index_sequence<abcdef::string::size>;
+  static_assert(std::is_same<
+                scry::parse_result<utf8_abcdef, abcdef_indices>::type,
+                scry::parse_result<abcdef, abcdef_indices>::type>::value);
+  constexpr auto all_sequences =
+      scry::utf8::byte_sequences::of(scry::utf8::code_point_set::all());
+  static_assert(all_sequences.size == 9 && all_sequences.single_bytes() == 1);
+  static_assert(scry::regex_match<utf8_dot>("aéc"));
+  static_assert(!scry::regex_match<a____f>("aéééf"));
+  assert(scry::regex_match<utf8_dot>("abc"));
+  assert(scry::regex_match<utf8_dot>("aéc"));
+  assert(scry::regex_match<utf8_dot>("a€c"));
+  assert(scry::regex_match<utf8_dot>("a\U0001F600c"));
+  assert(!scry::regex_match<utf8_dot>("aééc"));
+  assert(!scry::regex_match<utf8_dot>("a\xC3" "c"));
+  assert(!scry::regex_match<utf8_dot>("a\xED\xA0\x80" "c"));
+  assert(scry::regex_match<utf8_run>(""));
+  assert(scry::regex_match<utf8_run>("ééé"));
+  assert(!scry::regex_match<utf8_run>("ée"));
+  assert(scry::regex_match<utf8_range>("àéÿ"));
+  assert(!scry::regex_match<utf8_range>("é!"));
+  assert(!scry::regex_match<utf8_range>("ā"));
+  assert(scry::regex_match<utf8_not_a>("b€\U0001F600"));
+  assert(!scry::regex_match<utf8_not_a>("bac"));
+  assert(!scry::regex_match<utf8_not_a>("b€"));
+  assert(scry::regex_match<utf8_mixed>("aé€a"));
+  assert(!scry::regex_match<utf8_mixed>("aè"));
+  assert(scry::regex_match<utf8_field>("€,é,"));
+  assert(scry::regex_match<utf8_abcdef>("abcdef"));
+  auto accent = scry::regex_search<utf8_not_a>("aaaé€b");
+  assert(accent);
+  assert(std::string_view(accent.begin, accent.length()) == "é€b");
+  for (const char *str :
+       {"abc", "aéc", "a€c", "a\xC3" "c", "aé", "a\U0001F600c"}) {
+    assert((lazy_agrees<utf8_dot>(str)));
+    assert((bit_parallel_agrees<utf8_dot>(str)));
+  }
+  for (const char *str : {"b€\U0001F600", "bac", "ééé", "\xFF\xFF\xFF"}) {
+    assert((lazy_agrees<utf8_not_a>(str)));
+  }
+  assert(!scry::dynamic_regex::compile("a.c", utf8_basic));
+
+  // Test invalid UTF-8 input, which classes never match but which a starred
+  // "." or ASCII non-matching list that stays byte-level accepts
+  using utf8_accent_suffix =
+      scry::regex<utf8_accent_suffix_pattern, utf8_basic>;
+  assert(!scry::regex_match<utf8_dot>("a\xFF" "c"));
+  assert(!scry::regex_match<utf8_dot>("a\x80" "c"));
+  assert(!scry::regex_match<utf8_not_a>("\xFF\xFF\xFF"));
+  assert(!scry::regex_match<utf8_not_a>("b\x80" "c"));
+  assert(!scry::regex_match<utf8_run>("\xC3"));
+  assert(!scry::regex_match<utf8_mixed>("a\xE9"));
+  assert(scry::regex_match<utf8_accent_suffix>("aé"));
+  assert(!scry::regex_match<utf8_accent_suffix>("\xFFé"));
+  assert(scry::regex_match<utf8_field>("\xFF,"));
+
+  // Test selecting regexes by runtime ids
+  using routes = scry::registry<abcdef, id, field, anchored_abcdef>;
+  static_assert(routes::size == 4);
+  static_assert(routes::match(0, "abcdef"));
+  static_assert(!routes::match(2, "abcdef"));
+  static_assert(routes::search(1, "user 12 id 123456 ok").length() == 6);
+  assert(routes::match(2, "key,"));
+  assert(!routes::match(1, "12"));
+  assert(!routes::match(routes::size, "abcdef"));
+  assert(routes::match(3, std::string_view{"abcdef"}));
+  const std::string route_line = "x abcdef, 1234";
+  auto route = routes::search(2, route_line.begin(), route_line.end());
+  assert(route && std::string(route.begin, route.end) == "x abcdef,");
+  assert(!routes::search(3, route_line.begin(), route_line.end()));
+  assert(!routes::search(routes::size, route_line.begin(), route_line.end()));
+
+  // Test regexes keyed on the characters of their patterns
+  using namespace scry::literals;
+  using fixed_abcdef = decltype("abcdef"_re);
+  using fixed_field = decltype(R"([^,]*,)"_re);
+  static_assert(std::is_same<fixed_abcdef, decltype("abcdef"_re)>::value);
+  static_assert(std::is_same<
+                fixed_abcdef,
+                scry::fixed_regex<scry::trait::basic, 'a', 'b', 'c', 'd',
+                                  'e', 'f'>>::value);
+  static_assert(!std::is_same<fixed_abcdef, decltype("abcdeg"_re)>::value);
+  static_assert(scry::regex_match<fixed_abcdef>("abcdef"));
+  static_assert(!scry::regex_match<fixed_abcdef>("abcdeg"));
+  static_assert(
+      std::is_same<typename scry::explain::stages<fixed_field>::code,
+                   typename scry::explain::stages<field>::code>::value);
+  assert(scry::regex_match<fixed_field>(std::string{"a,"}));
+  assert(scry::regex_search<fixed_field>("x abcdef, 1234").length() == 9);
+  assert(std::strcmp(scry::explain::plan<fixed_field>().c_str(),
+                     scry::explain::plan<field>().c_str()) == 0);
+  using fixed_utf8_dot =
+      decltype("a.c"_re)::with_traits<scry::trait::basic | scry::trait::utf8>;
+  assert(scry::regex_match<fixed_utf8_dot>("a€c"));
+  assert(!scry::regex_match<decltype("a.c"_re)>("a€c"));
+  assert(dynamic_agrees<fixed_field>("abc,"));
+
+  // Test matching and searching for sets of words
+  using methods = scry::literal_set<get_word, post_word, put_word, patch_word>;
+  static_assert(methods::size == 4);
+  static_assert(methods::find("GET") == 0);
+  static_assert(methods::find("PATCH") == 3);
+  static_assert(methods::find("PUT") == 2);
+  static_assert(methods::find("PU") == methods::size);
+  static_assert(methods::find("PUTS") == methods::size);
+  static_assert(!methods::match(""));
+  assert(methods::match(std::string_view{"POST"}));
+  assert(!methods::match("get"));
+  const std::u16string wide_method = u"PATCH";
+  assert(methods::find(wide_method.begin(), wide_method.end()) == 3);
+  const std::u16string wide_other = u"PŐST";
+  assert(!methods::match(wide_other.begin(), wide_other.end()));
+  auto request = methods::search("curl -X POST /items");
+  assert(request && request.id == 1 &&
+         std::string(request.begin, request.end) == "POST");
+  assert(!methods::search("curl -X DELETE /items"));
+  using pronouns = scry::literal_set<he_word, she_word, his_word, hers_word>;
+  static_assert(pronouns::search("ushers").id == 1);
+  auto pronoun = pronouns::search("ushers");
+  assert(std::string(pronoun.begin, pronoun.end) == "she");
+  auto longest = pronouns::search(std::string{"xhersx"});
+  assert(longest.id == 3 && longest.length() == 4);
+  assert(pronouns::search("ahishe").id == 2);
+  const std::string pronoun_line = "this";
+  auto suffix = pronouns::search(pronoun_line.begin(), pronoun_line.end());
+  assert(suffix && suffix.id == 2 && suffix.begin == pronoun_line.begin() + 1);
+
+  // Test regexes compiled once behind non-template entry points
+  assert(precompiled_email::match("user.name@example.org"));
+  assert(!precompiled_email::match(std::string_view{"@example.org"}));
+  const std::string contact = "mail user@host.com now";
+  assert(!precompiled_email::match(contact.begin(), contact.end()));
+  auto contact_match = precompiled_email::search(contact.begin(),
+                                                 contact.end());
+  assert(contact_match &&
+         std::string(contact_match.begin, contact_match.end) ==
+             "user@host.com");
+  assert(formats::precompiled_fields::match("a,b,"));
+  assert(formats::precompiled_fields::search("x,y,z").length() == 4);
+  assert(!formats::precompiled_fields::search("x;y;z"));
+
+  // Test matching code units of other types and high bytes by value
+  using high_bytes = scry::regex<high_bytes_pattern>;
+  assert(scry::regex_match<high_bytes>("a\xe9\xff"));
+  assert(!scry::regex_match<high_bytes>("a\x1f"));
+  assert(dynamic_agrees<high_bytes>("a\xe9\xff"));
+  assert(dynamic_agrees<high_bytes>("\x80\x1f"));
+  assert(bit_parallel_agrees<high_bytes>("a\xe9\xff"));
+  assert((lazy_agrees<high_bytes>("\x80\x1f")));
+  assert(scry::regex_match<abcdef>(u"abcdef"));
+  assert(scry::regex_match<abcdef>(std::u16string_view(u"abcdef")));
+  assert(scry::regex_match<abcdef>(std::u32string(U"abcdef")));
+  assert(!scry::regex_match<abcdef>(u"abc\u0164ef"));
+  assert(scry::regex_match<a____f>(u"a\u00e9\u4e2d\U0001F600f"));
+  assert(scry::regex_match<not_some_lower>(U"\u0164\U0001F600"));
+  assert(!scry::regex_match<high_bytes>(u"a\u0164"));
+  assert(scry::regex_match<high_bytes>(u"a\u00e9\u00ff"));
+  assert(scry::regex_match<field>(L"a\u00e9,"));
+  assert(scry::regex_match<last_x_suffix>(L"\u0178x\u0178x1"));
+  static_assert(scry::regex_match<abcdef>(u8"abcdef"));
+  constexpr std::uint8_t payload[] = {0x00, 0xff, 'x', 0x80, 'x', '7'};
+  static_assert(scry::regex_match<last_x_suffix>(std::begin(payload),
+                                                 std::end(payload)));
+  assert(scry::regex_match<last_x_suffix>(std::begin(payload),
+                                          std::end(payload)));
+  auto payload_match =
+      scry::regex_search<id>(std::begin(payload), std::end(payload));
+  assert(!payload_match);
+  const std::u16string_view wide_field = u"\u0164\u0178,";
+  auto wide_match =
+      scry::regex_search<field>(wide_field.begin(), wide_field.end());
+  assert(wide_match && wide_match.length() == 3);
 }
@@ -0,0 +1,93 @@
+#include "code_size_config.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+namespace {
+
+/**
+ * Patterns whose code size is reported, from single ops to long programs of
+ * nested quantifiers
+ */
+constexpr const char *patterns[] = {
+    "abcdef",
+    "[^,]*,",
+    ".*x[[:digit:]]",
+    "[[:alnum:]._]\\{1,\\}@[[:alnum:].]\\{1,\\}",
+    "[^,]*,[^,]*,[^,]*,[^,]*,[^,]*",
+    "[[:alpha:]]*[[:digit:]]\\{1,4\\}[[:alnum:]]*-[[:xdigit:]]*x",
+    "a*b*c*d*e*f*g*h*",
+    "[a-z]\\{1,8\\}[0-9]\\{1,8\\}[A-Z]\\{1,8\\}[a-z]\\{1,8\\}",
+};
+
+/**
+ * Inlining limits compared for each pattern: one outlining sub-programs
+ * larger than 24, and the default, which inlines every op
+ */
+constexpr const char *limits[] = {"-DSCRY_INLINE_LIMIT=24", ""};
+
+void write_unit(const std::string &path, const char *pattern) {
+  std::ofstream out{path};
+  out << "#include \"scry.hpp\"\n\n"
+      << "constexpr static const char pattern[] = R\"scry(" << pattern
+      << ")scry\";\n\n"
+      << "bool match(const char *begin, const char *end) {\n"
+      << "  return scry::regex_match<scry::regex<pattern>>(begin, end);\n"
+      << "}\n";
+}
+
+/**
+ * Compiles a translation unit and returns the size in bytes of the code in
+ * the resulting object, or a negative value on failure
+ */
+long code_size(const std::string &path, const char *flags) {
+  const std::string object = path + ".o";
+  const std::string compile = std::string{"\""} + code_size_compiler +
+                              "\" -std=c++17 -O2 " + flags + " -I\"" +
+                              code_size_include + "\" -c " + path + " -o " +
+                              object;
+  if (std::system(compile.c_str()) != 0) {
+    return -1;
+  }
+  const std::string report = path + ".size";
+  const std::string measure = std::string{"\""} + code_size_tool + "\" " +
+                              object + " > " + report;
+  if (std::system(measure.c_str()) != 0) {
+    return -1;
+  }
+  // Berkeley format: a header line, then text, data, bss, ...
+  std::ifstream in{report};
+  std::string header;
+  long text = -1;
+  std::getline(in, header);
+  in >> text;
+  return text;
+}
+
+} // anonymous namespace
+
+/**
+ * Compiles a function matching each pattern with and without outlining of
+ * large sub-programs, and prints the size in bytes of the code of each
+ */
+int main() {
+  std::printf("%9s %9s  %s\n", "outlined", "inlined", "pattern");
+  for (std::size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); ++i) {
+    long sizes[2];
+    for (std::size_t j = 0; j < 2; ++j) {
+      const std::string path =
+          "pattern_" + std::to_string(i) + "_" + std::to_string(j) + ".cpp";
+      write_unit(path, patterns[i]);
+      sizes[j] = code_size(path, limits[j]);
+      if (sizes[j] < 0) {
+        std::fprintf(stderr, "failed to measure %s\n", path.c_str());
+        return EXIT_FAILURE;
+      }
+    }
+    std::printf("%9ld %9ld  %s\n", sizes[0], sizes[1], patterns[i]);
+    std::fflush(stdout);
+  }
+}
@@ -0,0 +1,139 @@
+#include "compile_bench_config.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+namespace {
+
+/**
+ * Family of patterns made by repeating `unit` up to `max_repeats` times, so
+ * that the cost of each stage can be compared as patterns grow
+ */
+struct family {
+  const char *name;
+  const char *unit;
+  std::size_t max_repeats;
+};
+
+constexpr family families[] = {
+    {"literal", "abcd", 16},
+    {"class", "[[:alnum:]_]", 16},
+    {"until", "[^,]*,", 16},
+    // Nested bounded repeats grow the generated program much faster than the
+    // other families, so are kept short enough to compile in seconds
+    {"bounded", R"(a\{1,4\})", 8},
+};
+
+constexpr std::size_t repeats[] = {1, 2, 4, 8, 16};
+
+/**
+ * Stages of compiling a regex, each instantiated on top of the previous one.
+ * The `include` stage only includes the library, so that the cost of parsing
+ * the headers can be subtracted from the first stage.
+ */
+constexpr const char *stages[] = {"include", "parse", "optimise", "codegen",
+                                  "execute"};
+constexpr std::size_t stage_count = sizeof(stages) / sizeof(stages[0]);
+
+void write_unit(const std::string &path, const std::string &pattern,
+                std::size_t stage) {
+  std::ofstream out{path};
+  out << "#include \"scry.hpp\"\n\n"
+      << "#include <utility>\n\n"
+      << "constexpr static const char pattern[] = R\"scry(" << pattern
+      << ")scry\";\n"
+      << "using regex = scry::regex<pattern>;\n"
+      << "using indices = std::make_index_sequence<regex::string::size>;\n";
+  if (stage >= 1) {
+    out << "using tree = scry::parse_result<regex, indices>::type;\n";
+  }
+  if (stage >= 2) {
+    out << "using opt_tree = scry::optimise_result<tree>::type;\n";
+  }
+  if (stage >= 3) {
+    out << "using code = scry::codegen_result<opt_tree>::type;\n";
+  }
+  if (stage >= 4) {
+    out << "bool match(const char *begin, const char *end) {\n"
+        << "  return scry::op::dispatch<code>(begin, end) == end;\n"
+        << "}\n";
+  }
+}
+
+/**
+ * Compiles a translation unit, keeping the compiler's own timing report next
+ * to it, and returns the wall-clock time taken in milliseconds or a negative
+ * value if compilation failed
+ */
+double compile(const std::string &path) {
+  const std::string command = std::string{"\""} + compile_bench_compiler +
+                              "\" -std=c++17 -O0 -I\"" +
+                              compile_bench_include + "\" " +
+                              compile_bench_report_flag + " -c " + path +
+                              " -o " + path + ".o 2> " + path + ".report";
+  const auto start = std::chrono::steady_clock::now();
+  const int status = std::system(command.c_str());
+  const auto stop = std::chrono::steady_clock::now();
+  if (status != 0) {
+    return -1;
+  }
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+} // anonymous namespace
+
+/**
+ * Generates translation units instantiating each stage of compiling patterns
+ * of increasing length and complexity, times their compilation and prints the
+ * cost of each stage in milliseconds. Each unit is compiled `repetitions`
+ * times (default 3) and the fastest compilation is kept.
+ *
+ * Usage: compile_bench [repetitions]
+ */
+int main(int argc, char **argv) {
+  const int repetitions = argc > 1 ? std::max(1, std::atoi(argv[1])) : 3;
+  std::printf("%-8s %6s %7s", "family", "length", "headers");
+  for (std::size_t stage = 1; stage < stage_count; ++stage) {
+    std::printf(" %9s", stages[stage]);
+  }
+  std::printf(" %9s\n", "total");
+  std::fflush(stdout);
+  for (const family &f : families) {
+    for (std::size_t n : repeats) {
+      if (n > f.max_repeats) {
+        break;
+      }
+      std::string pattern;
+      for (std::size_t i = 0; i < n; ++i) {
+        pattern += f.unit;
+      }
+      double times[stage_count]{};
+      for (std::size_t stage = 0; stage < stage_count; ++stage) {
+        const std::string path = std::string{f.name} + "_" +
+                                 std::to_string(n) + "_" + stages[stage] +
+                                 ".cpp";
+        write_unit(path, pattern, stage);
+        times[stage] = -1;
+        for (int i = 0; i < repetitions; ++i) {
+          const double time = compile(path);
+          if (time < 0) {
+            std::fprintf(stderr, "failed to compile %s\n", path.c_str());
+            return EXIT_FAILURE;
+          }
+          times[stage] = times[stage] < 0 ? time : std::min(times[stage], time);
+        }
+      }
+      std::printf("%-8s %6zu %7.0f", f.name, pattern.size(), times[0]);
+      for (std::size_t stage = 1; stage < stage_count; ++stage) {
+        std::printf(" %9.1f", times[stage] - times[stage - 1]);
+      }
+      std::printf(" %9.1f\n", times[stage_count - 1] - times[0]);
+      std::fflush(stdout);
+    }
+  }
+}
@@ -0,0 +1,15 @@
+#include "explain.hpp"
+#include "explain_pattern.hpp"
+#include "scry.hpp"
+
+#include <cstdio>
+
+/**
+ * Prints the compilation plan of the pattern configured with
+ * `SCRY_EXPLAIN_PATTERN`
+ */
+int main() {
+  using pattern = scry::regex<explain_pattern>;
+  constexpr auto plan = scry::explain::plan<pattern>();
+  std::fputs(plan.c_str(), stdout);
+}